@@ -0,0 +1,379 @@
+//
+//  LatencyBenchmark.cpp
+//  DrumNetworkController
+//
+//  Copyright © 2017 Jeff Gregorio. All rights reserved.
+//
+//  End-to-end MIDI-to-OSC latency benchmark for DrumNetworkController.
+//
+//  Stands in for a MIDI controller and a set of drum nodes:
+//    - Registers N fake nodes with the controller by sending /ip "iiii" to its server
+//      port, using loopback addresses 127.0.0.<first_host + i>.
+//    - Binds a UDP sink on each fake node's address at the node port (7770).
+//    - Selects the note allocation mode with CC 76 (value = segment index).
+//    - Sends note on/off pairs through the controller's "Drumhenge" virtual MIDI input
+//      at increasing rates, optionally with a CC stream mapped to OSC parameters.
+//    - Matches each /note "ii" packet received by the sinks to the MIDI message that
+//      caused it and reports p50/p99/max latency and jitter (standard deviation).
+//
+//  Build (from DrumNetworkController/Benchmark):
+//    Linux:
+//      g++ -O2 -std=c++11 -D__LINUX_ALSA__ -I.. LatencyBenchmark.cpp ../RtMidi.cpp
+//          -lasound -lpthread -o latency_benchmark
+//    macOS:
+//      clang++ -O2 -std=c++11 -D__MACOSX_CORE__ -I.. LatencyBenchmark.cpp ../RtMidi.cpp
+//          -framework CoreMIDI -framework CoreAudio -framework CoreFoundation
+//          -o latency_benchmark
+//
+//  Usage:
+//    latency_benchmark [-n nodes] [-m mode] [-r rate1,rate2,...] [-c cc_per_note]
+//                      [-d seconds] [-h first_host] [-p midi_port_name]
+//
+//  Start DrumNetworkController first, with no real nodes on the network. On macOS,
+//  loopback aliases are needed for each fake node, e.g.
+//    sudo ifconfig lo0 alias 127.0.0.11 up
+//
+
+#include "RtMidi.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define kController_Port (7771)     // Controller's OSC server (kMulticast_Port)
+#define kNode_Port (7770)           // Node UDP port (kLocal_Port)
+#define kAllocationModeCC (76)      // CC selecting the allocation mode segment
+#define kNoteIdCount (64 * 126)     // Distinct (note, velocity) pairs used as message ids
+
+typedef std::chrono::steady_clock Clock;
+
+typedef struct BenchmarkConfig {
+    int num_nodes;
+    int mode;
+    std::vector<double> rates;      // Note on/off pairs per second
+    int cc_per_note;                // CC messages sent between note pairs
+    double duration_s;              // Duration of each rate step
+    int first_host;                 // Fake nodes use 127.0.0.<first_host + i>
+    std::string port_name;          // Controller's virtual MIDI input
+} BenchmarkConfig;
+
+typedef struct LatencyStats {
+    int sent;
+    int received;
+    int extra;                      // Additional packets (note offs, all-on copies)
+    double p50_ms;
+    double p99_ms;
+    double max_ms;
+    double jitter_ms;
+} LatencyStats;
+
+// Send times indexed by message id; written by the sender, read by the receiver
+static std::vector<std::atomic<int64_t>> send_time_ns(kNoteIdCount);
+static std::vector<std::atomic<bool>> matched(kNoteIdCount);
+static std::vector<double> latencies_ms;
+static std::atomic<int> extra_packets(0);
+static std::atomic<bool> receiving(false);
+
+static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               Clock::now().time_since_epoch()).count();
+}
+
+static int note_for_id(int id) { return 36 + id % 64; }
+static int velocity_for_id(int id) { return 1 + id / 64; }
+static int id_for_note(int num, int vel) { return (vel - 1) * 64 + (num - 36); }
+
+/**
+ * Big-endian int32 at the given address.
+ */
+static int32_t read_int32(const unsigned char *p) {
+    return (int32_t)(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+                     ((uint32_t)p[2] << 8) | (uint32_t)p[3]);
+}
+
+static void write_int32(unsigned char *p, int32_t v) {
+    p[0] = (v >> 24) & 0xFF;
+    p[1] = (v >> 16) & 0xFF;
+    p[2] = (v >> 8) & 0xFF;
+    p[3] = v & 0xFF;
+}
+
+/**
+ * Announce fake node addresses to the controller as if they had answered /get_ip.
+ */
+static bool register_nodes(const BenchmarkConfig &cfg) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+        return false;
+    sockaddr_in dest;
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(kController_Port);
+    dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    for (int i = 0; i < cfg.num_nodes; i++) {
+        unsigned char packet[28] = {'/', 'i', 'p', 0, ',', 'i', 'i', 'i', 'i', 0, 0, 0};
+        write_int32(packet + 12, 127);
+        write_int32(packet + 16, 0);
+        write_int32(packet + 20, 0);
+        write_int32(packet + 24, cfg.first_host + i);
+        sendto(fd, packet, sizeof(packet), 0, (sockaddr *)&dest, sizeof(dest));
+    }
+    close(fd);
+    return true;
+}
+
+/**
+ * Open one UDP sink per fake node, bound to 127.0.0.<first_host + i>:7770.
+ */
+static std::vector<int> open_sinks(const BenchmarkConfig &cfg) {
+    std::vector<int> fds;
+    for (int i = 0; i < cfg.num_nodes; i++) {
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(kNode_Port);
+        addr.sin_addr.s_addr = htonl((127 << 24) | (cfg.first_host + i));
+        if (fd < 0 || bind(fd, (sockaddr *)&addr, sizeof(addr)) < 0) {
+            fprintf(stderr, "failed to bind sink 127.0.0.%d:%d\n", cfg.first_host + i, kNode_Port);
+            if (fd >= 0)
+                close(fd);
+            for (int j = 0; j < fds.size(); j++)
+                close(fds[j]);
+            return std::vector<int>();
+        }
+        fds.push_back(fd);
+    }
+    return fds;
+}
+
+/**
+ * Receive /note "ii" packets on every sink and match note ons to their send times.
+ */
+static void receive_loop(std::vector<int> fds) {
+    std::vector<pollfd> pfds(fds.size());
+    for (int i = 0; i < fds.size(); i++) {
+        pfds[i].fd = fds[i];
+        pfds[i].events = POLLIN;
+    }
+
+    unsigned char buf[1024];
+    while (receiving) {
+        if (poll(&pfds[0], pfds.size(), 10) <= 0)
+            continue;
+        int64_t t_ns = now_ns();
+        for (int i = 0; i < pfds.size(); i++) {
+            if (!(pfds[i].revents & POLLIN))
+                continue;
+            ssize_t len = recv(pfds[i].fd, buf, sizeof(buf), 0);
+            // "/note\0\0\0" ",ii\0" <int32><int32>
+            if (len != 20 || memcmp(buf, "/note\0\0\0,ii\0", 12) != 0) {
+                extra_packets++;
+                continue;
+            }
+            int num = read_int32(buf + 12);
+            int vel = read_int32(buf + 16);
+            if (vel == 0 || num < 36 || num >= 100 || vel > 126) {
+                extra_packets++;
+                continue;
+            }
+            int id = id_for_note(num, vel);
+            if (matched[id].exchange(true)) {
+                extra_packets++;
+                continue;
+            }
+            latencies_ms.push_back((t_ns - send_time_ns[id].load()) * 1e-6);
+        }
+    }
+}
+
+static double percentile(std::vector<double> &sorted, double p) {
+    if (sorted.empty())
+        return 0.0;
+    int idx = (int)ceil(p * sorted.size()) - 1;
+    return sorted[std::min(std::max(idx, 0), (int)sorted.size() - 1)];
+}
+
+/**
+ * Send note on/off pairs at the given rate for the configured duration.
+ */
+static LatencyStats run_step(RtMidiOut &midi_out, const BenchmarkConfig &cfg,
+                             const std::vector<int> &fds, double rate) {
+
+    for (int i = 0; i < kNoteIdCount; i++)
+        matched[i] = false;
+    latencies_ms.clear();
+    latencies_ms.reserve(kNoteIdCount);
+    extra_packets = 0;
+
+    receiving = true;
+    std::thread receiver(receive_loop, fds);
+
+    std::vector<unsigned char> msg(3);
+    int num_pairs = std::min((int)(rate * cfg.duration_s), kNoteIdCount);
+    Clock::duration period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / rate));
+    Clock::time_point next = Clock::now();
+
+    for (int id = 0; id < num_pairs; id++) {
+        std::this_thread::sleep_until(next);
+        next += period;
+
+        int num = note_for_id(id);
+        msg[0] = 0x90;
+        msg[1] = num;
+        msg[2] = velocity_for_id(id);
+        send_time_ns[id] = now_ns();
+        midi_out.sendMessage(&msg);
+
+        // Parameter traffic between notes (default controller mappings on CC 20-26)
+        for (int k = 0; k < cfg.cc_per_note; k++) {
+            msg[0] = 0xB0;
+            msg[1] = 20 + k % 7;
+            msg[2] = (id + k) % 128;
+            midi_out.sendMessage(&msg);
+        }
+
+        msg[0] = 0x80;
+        msg[1] = num;
+        msg[2] = 0;
+        midi_out.sendMessage(&msg);
+    }
+
+    // Allow stragglers to arrive
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    receiving = false;
+    receiver.join();
+
+    LatencyStats stats;
+    stats.sent = num_pairs;
+    stats.received = (int)latencies_ms.size();
+    stats.extra = extra_packets;
+
+    double mean = 0.0, var = 0.0;
+    for (int i = 0; i < latencies_ms.size(); i++)
+        mean += latencies_ms[i];
+    mean /= std::max((int)latencies_ms.size(), 1);
+    for (int i = 0; i < latencies_ms.size(); i++)
+        var += (latencies_ms[i] - mean) * (latencies_ms[i] - mean);
+    var /= std::max((int)latencies_ms.size(), 1);
+
+    std::sort(latencies_ms.begin(), latencies_ms.end());
+    stats.p50_ms = percentile(latencies_ms, 0.50);
+    stats.p99_ms = percentile(latencies_ms, 0.99);
+    stats.max_ms = latencies_ms.empty() ? 0.0 : latencies_ms.back();
+    stats.jitter_ms = sqrt(var);
+    return stats;
+}
+
+static std::vector<double> parse_rates(const char *arg) {
+    std::vector<double> rates;
+    std::string s(arg);
+    size_t start = 0;
+    while (start < s.size()) {
+        size_t end = s.find(',', start);
+        if (end == std::string::npos)
+            end = s.size();
+        double r = atof(s.substr(start, end - start).c_str());
+        if (r > 0.0)
+            rates.push_back(r);
+        start = end + 1;
+    }
+    return rates;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr,
+            "usage: %s [-n nodes] [-m mode] [-r rate1,rate2,...] [-c cc_per_note]\n"
+            "          [-d seconds] [-h first_host] [-p midi_port_name]\n"
+            "  mode: 0 sequential, 1 random, 2 distributed, 3 all on, 4 hemispheric\n", name);
+}
+
+int main(int argc, char *argv[]) {
+
+    BenchmarkConfig cfg;
+    cfg.num_nodes = 4;
+    cfg.mode = 0;
+    cfg.rates = parse_rates("10,50,100,200,500,1000");
+    cfg.cc_per_note = 0;
+    cfg.duration_s = 5.0;
+    cfg.first_host = 11;
+    cfg.port_name = "Drumhenge";
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:m:r:c:d:h:p:")) != -1) {
+        switch (opt) {
+            case 'n': cfg.num_nodes = atoi(optarg); break;
+            case 'm': cfg.mode = atoi(optarg); break;
+            case 'r': cfg.rates = parse_rates(optarg); break;
+            case 'c': cfg.cc_per_note = atoi(optarg); break;
+            case 'd': cfg.duration_s = atof(optarg); break;
+            case 'h': cfg.first_host = atoi(optarg); break;
+            case 'p': cfg.port_name = optarg; break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (cfg.num_nodes < 1 || cfg.first_host + cfg.num_nodes > 255 || cfg.rates.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<int> fds = open_sinks(cfg);
+    if (fds.empty())
+        return 1;
+
+    // Connect to the controller's virtual MIDI input
+    RtMidiOut midi_out;
+    int port = -1;
+    for (unsigned int i = 0; i < midi_out.getPortCount(); i++) {
+        if (midi_out.getPortName(i).find(cfg.port_name) != std::string::npos)
+            port = i;
+    }
+    if (port < 0) {
+        fprintf(stderr, "MIDI port \"%s\" not found; is DrumNetworkController running?\n",
+                cfg.port_name.c_str());
+        return 1;
+    }
+    midi_out.openPort(port);
+
+    register_nodes(cfg);
+    std::vector<unsigned char> msg(3);
+    msg[0] = 0xB0;
+    msg[1] = kAllocationModeCC;
+    msg[2] = cfg.mode;
+    midi_out.sendMessage(&msg);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    printf("nodes: %d  mode: %d  cc/note: %d  step: %.1f s\n",
+           cfg.num_nodes, cfg.mode, cfg.cc_per_note, cfg.duration_s);
+    printf("%10s %8s %8s %8s %10s %10s %10s %10s\n",
+           "notes/s", "sent", "recv", "extra", "p50 ms", "p99 ms", "max ms", "jitter ms");
+    for (int i = 0; i < cfg.rates.size(); i++) {
+        LatencyStats s = run_step(midi_out, cfg, fds, cfg.rates[i]);
+        printf("%10.1f %8d %8d %8d %10.3f %10.3f %10.3f %10.3f\n",
+               cfg.rates[i], s.sent, s.received, s.extra,
+               s.p50_ms, s.p99_ms, s.max_ms, s.jitter_ms);
+        fflush(stdout);
+    }
+
+    for (int i = 0; i < fds.size(); i++)
+        close(fds[i]);
+    return 0;
+}
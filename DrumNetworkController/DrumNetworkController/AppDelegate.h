@@ -12,13 +12,22 @@
 #include <stdlib.h>
 #include <vector>
 #include <map>
+#include <string>
+#include <memory>
 #include "RtMidi.h"
+#include "NodeVoiceAllocator.h"
+#include "NodeTelemetry.h"
+#include "ParameterSender.h"
+#include "OscSender.h"
 
 #define kMulticast_Address "239.0.0.1"
 #define kMulticast_Port "7771"
 #define kLocal_Port "7770"
 #define kMIDIDeviceQueryIntervalSeconds (5.0)
 #define kMIDICCTimerInterval (0.01)
+#define kParameterSlowMaxRateHz (20.0)     // Paths that make nodes recompute coefficients
+#define kHeartbeatIntervalMilliseconds (50)
+#define kTelemetryIntervalMilliseconds (5000)
 
 @interface AppDelegate : NSObject <NSApplicationDelegate, NSTableViewDelegate, NSTableViewDataSource> {
     
@@ -27,19 +36,18 @@
     int numMidiDevices;
     std::map<int, int> noteAddressMap;
     std::vector<int> node_idx_randperm;
-    std::vector<int> node_idx_distributed;
     std::vector<int> node_idx_hemispheric;
     int node_idx;
+    NodeVoiceAllocator voice_allocator;     // Distributed (state-aware) allocation
+    NodeTelemetry node_telemetry;           // Per-node message plane counters
     
     // MIDI CC
     NSMutableArray *cc_paths;       // CC mapping output OSC paths
     int cc_nums[8];                 // CC mapping source num
     float cc_min[8];                // CC output range min
     float cc_max[8];                // " " " max
-    float cc_scaled_current[8];     // CC output (scaled)
-    bool cc_scaled_changed[8];      // CC output update flag
-    NSTimer *midi_cc_timer;         // CC output update timer
-    int cc_update_idx;              // CC output to update
+    NSTimer *midi_cc_timer;         // CC/parameter output update timer
+    ParameterSender parameter_sender;   // Coalesced CC and slider parameter output
     
     lo_server_thread osc_server_thread;
     lo_address multicast_address;
@@ -47,6 +55,14 @@
     
     std::vector<lo_address> node_addresses;
     
+    // Asynchronous output for the MIDI thread; destinations resolved once per node on the
+    // main queue. The MIDI thread reads an immutable copy of node_dests, replaced with
+    // std::atomic_store whenever the node list changes.
+    OscSender osc_sender;
+    std::vector<int> node_dests;
+    std::shared_ptr<const std::vector<int> > midi_node_dests;
+    int multicast_dest;
+    
     // All on allocation
     int num_notes_previous;
     std::vector<int> current_notes;
@@ -63,6 +79,8 @@
 - (void)midi_cc_handler:(int)num value:(int)val;
 
 - (void)add_node:(const char *)address;
+- (void)node_heartbeat:(const char *)address state:(int)state level:(float)level;
+- (void)node_telemetry:(const char *)address report:(const NodeTelemetryReport &)report;
 
 @property IBOutlet NSTableView *nodeTableView;
 
@@ -117,6 +135,7 @@
 - (IBAction)multi_send_get_ip:(id)sender;
 - (IBAction)multi_send_remove_listeners:(id)sender;
 - (std::vector<lo_address>)get_node_addresses;
+- (ParameterSender *)get_parameter_sender;
 
 #pragma mark - Propagation
 - (IBAction)propagation_enabled_changed:(NSButton *)sender;
@@ -24,6 +24,30 @@ int ip_handler(const char *path, const char *types, lo_arg ** argv, int argc, vo
     return 1;
 }
 
+int heartbeat_handler(const char *path, const char *types, lo_arg ** argv, int argc, void *data, void *user_data) {
+    
+    AppDelegate *delegate = (__bridge AppDelegate *)user_data;
+    
+    lo_address source = lo_message_get_source((lo_message)data);
+    [delegate node_heartbeat:lo_address_get_hostname(source) state:argv[0]->i level:argv[1]->f];
+    
+    return 0;   // Handled; don't print heartbeats in the generic handler
+}
+
+int telemetry_handler(const char *path, const char *types, lo_arg ** argv, int argc, void *data, void *user_data) {
+    
+    AppDelegate *delegate = (__bridge AppDelegate *)user_data;
+    
+    NodeTelemetryReport report;
+    if (!NodeTelemetry::parse(types, argv, argc, report))
+        return 1;   // Malformed; let the generic handler print it
+    
+    lo_address source = lo_message_get_source((lo_message)data);
+    [delegate node_telemetry:lo_address_get_hostname(source) report:report];
+    
+    return 0;
+}
+
 int generic_handler(const char *path, const char *types, lo_arg ** argv, int argc, void *data, void *user_data) {
     
     printf("\npath: <%s>\n", path);
@@ -38,33 +62,35 @@ int generic_handler(const char *path, const char *types, lo_arg ** argv, int arg
     return 1;
 }
 
-void midiCallback(double deltatime, std::vector< unsigned char > *message, void *userData) {
+// Messages from every selected device (and the virtual port) arrive here on one
+// thread, tagged with the device's port number (-1 for the virtual port)
+void midiCallback(double deltatime, const unsigned char *message, size_t nBytes, int source, void *userData) {
     
-    unsigned int nBytes = (unsigned int)message->size();
-    
-    // Only interested in note on/off messages
-//    if (nBytes != 3)
-//        return;
+    if (nBytes == 0)
+        return;
     
     AppDelegate *delegate = (__bridge AppDelegate*)userData;
     
-    int cmd = message->at(0);
+    int cmd = message[0];
     int status = (cmd & 0xF0);
     
     switch (status) {
         case 0x90:      // Note on
-            [delegate midi_note_handler:message->at(1) velocity:message->at(2)];
+            if (nBytes == 3)
+                [delegate midi_note_handler:message[1] velocity:message[2]];
             break;
         case 0x80:      // Note off
-            [delegate midi_note_handler:message->at(1) velocity:0];
+            if (nBytes == 3)
+                [delegate midi_note_handler:message[1] velocity:0];
             break;
         case 0xB0:      // Control change
-            [delegate midi_cc_handler:message->at(1) value:message->at(2)];
+            if (nBytes == 3)
+                [delegate midi_cc_handler:message[1] value:message[2]];
             break;
         default:
-            printf("MIDI: ");
+            printf("MIDI (%d): ", source);
             for (int i = 0; i < nBytes; i++)
-                printf("%d\t", message->at(i));
+                printf("%d\t", message[i]);
             printf("\n");
             break;
     }
@@ -84,6 +110,7 @@ void midiCallback(double deltatime, std::vector< unsigned char > *message, void
 
 - (void)applicationWillTerminate:(NSNotification *)aNotification {
     lo_server_thread_free(osc_server_thread);
+    osc_sender.stop();
 }
 
 - (void)setup {
@@ -91,6 +118,7 @@ void midiCallback(double deltatime, std::vector< unsigned char > *message, void
     // MIDI Devices
     midiIn = new RtMidiIn();
     numMidiDevices = 0;
+    [_midiDevicePopUpButton setAltersStateOfSelectedItem:NO];
     [self query_midi_devices];
     
     // Set up timer to query MIDI devices periodically
@@ -106,13 +134,29 @@ void midiCallback(double deltatime, std::vector< unsigned char > *message, void
     // MIDI CC
     [self setUpMIDICCMapping];
     
+    // Flush coalesced CC/slider parameters at a fixed rate
+    midi_cc_timer = [NSTimer scheduledTimerWithTimeInterval:kMIDICCTimerInterval
+                                                     target:self
+                                                   selector:@selector(flush_parameters)
+                                                   userInfo:nil
+                                                    repeats:YES];
+    
     for (int i = 0; i < 127; i++)
         noteAddressMap[i] = -1;
     midiIn->openVirtualPort("Drumhenge");
+    midiIn->setViewCallback(&midiCallback, (__bridge void*)self);
     
     // OSC server
     osc_server_thread = lo_server_thread_new(kMulticast_Port, error);
     local_address = lo_address_new("10.0.1.2", kLocal_Port);
+    lo_server_thread_add_method(osc_server_thread,
+                                "/heartbeat", "if",
+                                heartbeat_handler,
+                                (__bridge void *)self);
+    lo_server_thread_add_method(osc_server_thread,
+                                "/telemetry", NULL,
+                                telemetry_handler,
+                                (__bridge void *)self);
     lo_server_thread_add_method(osc_server_thread,
                                 NULL, NULL,
                                 generic_handler,
@@ -125,6 +169,19 @@ void midiCallback(double deltatime, std::vector< unsigned char > *message, void
     
     // OSC client
     multicast_address = lo_address_new(kMulticast_Address, kMulticast_Port);
+    osc_sender.start();
+    multicast_dest = osc_sender.addDestination(kMulticast_Address, kMulticast_Port);
+    [self publish_node_dests];
+    parameter_sender.setOutput(&osc_sender);
+    const char *slow_paths[] = {
+        "/mod/lfo/rate",
+        "/mod/egen/atk_time", "/mod/egen/sus_level", "/mod/egen/rel_time",
+        "/ch2/mod/egen/atk_time", "/ch2/mod/egen/sus_level", "/ch2/mod/egen/rel_time"
+    };
+    for (int i = 0; i < sizeof(slow_paths) / sizeof(slow_paths[0]); i++)
+        parameter_sender.setMaxRate(slow_paths[i], kParameterSlowMaxRateHz);
+    [self multi_send_heartbeat_request];
+    [self multi_send_telemetry_request];
     
     // TableView
     [_nodeTableView setDelegate:self];
@@ -174,6 +231,9 @@ void midiCallback(double deltatime, std::vector< unsigned char > *message, void
             }
             if (!found) {
                 NSLog(@"%s: removed device %d: %@", __func__, j, [_midiDevicePopUpButton itemTitleAtIndex:j]);
+                NSMenuItem *item = [_midiDevicePopUpButton itemAtIndex:j];
+                if ([item state] == NSOnState)
+                    midiIn->removePort((unsigned int)[item tag]);
                 [_midiDevicePopUpButton removeItemAtIndex:j];
             }
         }
@@ -184,38 +244,40 @@ void midiCallback(double deltatime, std::vector< unsigned char > *message, void
 #pragma mark - MIDI Note Handling/Allocation
 - (void)midi_note_handler:(int)num velocity:(int)vel {
     
-    if (node_addresses.size() == 0)
+    // Node destinations as of the last change on the main queue
+    std::shared_ptr<const std::vector<int> > dests = std::atomic_load(&midi_node_dests);
+    if (!dests || dests->size() == 0)
         return;
     
-    lo_address dest;
     int dest_idx;
     
     if ([_midiNoteAllocationModeControl selectedSegment] == 3)
-        [self allocate_all_on:num velocity:vel];
+        [self allocate_all_on:num velocity:vel dests:*dests];
     
     else {  // All other allocation modes
         
         // Note ON
         if (vel != 0) {
             dest_idx = [self allocate_node];
-            dest = node_addresses[dest_idx];
+            if (dest_idx < 0 || dest_idx >= dests->size())
+                return;
             noteAddressMap[num] = dest_idx;
-            NSLog(@"%s: -- NOTE ON: assigning to node %s", __func__, lo_address_get_hostname(dest));
-            lo_send(dest, "/note", "ii", num, vel);
+            voice_allocator.noteOn(dest_idx, vel / 127.0f);
+            osc_sender.send((*dests)[dest_idx], "/note", "ii", num, vel);
         }
         // Note OFF
         else {
-            dest = node_addresses[noteAddressMap[num]];
-            if (dest) {
-                NSLog(@"%s: -- NOTE OFF: turning off node %s", __func__, lo_address_get_hostname(dest));
-                lo_send(dest, "/note", "ii", num, vel);
-                noteAddressMap[num] = -1;
-            }
+            dest_idx = noteAddressMap[num];
+            if (dest_idx < 0 || dest_idx >= dests->size())
+                return;
+            osc_sender.send((*dests)[dest_idx], "/note", "ii", num, vel);
+            voice_allocator.noteOff(dest_idx);
+            noteAddressMap[num] = -1;
         }
     }
 }
 
-- (void)allocate_all_on:(int)num velocity:(int)vel {
+- (void)allocate_all_on:(int)num velocity:(int)vel dests:(const std::vector<int> &)dests {
 
     int num_nodes = (int)node_addresses.size();
     int num_notes;
@@ -263,13 +325,14 @@ void midiCallback(double deltatime, std::vector< unsigned char > *message, void
     }
     
     // Send messages to nodes needing update
-    for (int i = 0; i < node_note_nums.size(); i++) {
+    for (int i = 0; i < node_note_nums.size() && i < dests.size(); i++) {
         if (node_note_nums[i] == -1)                                // Note off
-            lo_send(node_addresses[i], "/note", "ii", num, 0);
+            osc_sender.send(dests[i], "/note", "ii", num, 0);
         else if (node_note_nums_previous[i] == -1)                  // Note on
-            lo_send(node_addresses[i], "/note", "ii", num, vel);
-        else if (node_note_nums_previous[i] != node_note_nums[i])   // Pitch change
-            lo_send(node_addresses[i], "/synth/vco/freq_", "f", powf(2.0, (num - 69) / 12.0) * 440.0);
+            osc_sender.send(dests[i], "/note", "ii", num, vel);
+        else if (node_note_nums_previous[i] != node_note_nums[i])   // Pitch change (node glides)
+            osc_sender.send(dests[i], "/synth/vco/freq", "f",
+                            powf(2.0, (node_note_nums[i] - 69) / 12.0) * 440.0);
     }
     num_notes_previous = num_notes;
 }
@@ -281,8 +344,10 @@ void midiCallback(double deltatime, std::vector< unsigned char > *message, void
         case 1:         // Random
             idx = node_idx_randperm[node_idx];
             break;
-        case 2:         // Distributed
-            idx = node_idx_distributed[node_idx];
+        case 2:         // Distributed (idle/quietest node first)
+            idx = voice_allocator.allocate();
+            if (idx < 0 || idx >= node_addresses.size())
+                idx = node_idx;
             break;
         case 4:         // Hemispheric
             idx = node_idx_hemispheric[node_idx];
@@ -313,12 +378,6 @@ void midiCallback(double deltatime, std::vector< unsigned char > *message, void
     return vec;
 }
 
-- (std::vector<int>)arrange_distributed:(int)num_nodes {
-    std::vector<int> vec;
-    
-    return vec;
-}
-
 - (std::vector<int>)arrange_hemispheric:(int)num_nodes {
     std::vector<int> vec;
     int i, j, k;
@@ -497,11 +556,11 @@ void midiCallback(double deltatime, std::vector< unsigned char > *message, void
     }
     
     if (num == 64) {
-        lo_send(multicast_address, "/mod/egen/do_sus", "i", val < 63 ? 0 : 1);
+        osc_sender.send(multicast_dest, "/mod/egen/do_sus", "i", val < 63 ? 0 : 1);
         return;
     }
     else if (num == 59) {
-        lo_send(multicast_address, "/propagate/kill", NULL);
+        osc_sender.send(multicast_dest, "/propagate/kill", NULL);
     }
     else if (num == 75) {
         if (val > 63) {
@@ -512,6 +571,10 @@ void midiCallback(double deltatime, std::vector< unsigned char > *message, void
         if (val > 63)
             [_midiNoteAllocationModeControl setSelectedSegment:3];
     }
+    else if (num == 76) {       // Select allocation mode by segment index
+        if (val < [_midiNoteAllocationModeControl segmentCount])
+            [_midiNoteAllocationModeControl setSelectedSegment:val];
+    }
     else if (num == 80) {
         if (val > 63)
             [_propagation_enabled_check setState:NSOnState];
@@ -550,10 +613,18 @@ void midiCallback(double deltatime, std::vector< unsigned char > *message, void
         float min = cc_min[cc_idx];
         float max = cc_max[cc_idx];
         float scaled_val = (max-min) * (val/127.) + min;
-        lo_send(multicast_address, [cc_paths[cc_idx] UTF8String], "f", scaled_val);
+        parameter_sender.set(multicast_dest, [cc_paths[cc_idx] UTF8String], scaled_val);
     }
 }
 
+- (void)flush_parameters {
+    parameter_sender.flush();
+}
+
+- (ParameterSender *)get_parameter_sender {
+    return &parameter_sender;
+}
+
 - (IBAction)midi_cc_selected:(NSPopUpButton *)sender {
     cc_nums[(int)sender.tag] = (int)sender.selectedTag;
 }
@@ -572,9 +643,34 @@ void midiCallback(double deltatime, std::vector< unsigned char > *message, void
 
 #pragma mark - Network Config
 - (IBAction)multi_send_get_ip:(id)sender {
+    for (int i = 0; i < node_dests.size(); i++)
+        parameter_sender.removeDestination(node_dests[i]);
     node_addresses.clear();
+    node_dests.clear();
+    [self publish_node_dests];
+    voice_allocator.clear();
     [node_windows removeAllObjects];
     lo_send(multicast_address, "/get_ip", NULL);
+    [self multi_send_heartbeat_request];
+    [self multi_send_telemetry_request];
+}
+
+/**
+ * Ask every node to report its envelope state and level to this controller's server
+ * port every kHeartbeatIntervalMilliseconds.
+ */
+- (void)multi_send_heartbeat_request {
+    lo_send(multicast_address, "/heartbeat", "ii",
+            kHeartbeatIntervalMilliseconds, atoi(kMulticast_Port));
+}
+
+/**
+ * Ask every node to report its message plane counters to this controller's server port
+ * every kTelemetryIntervalMilliseconds.
+ */
+- (void)multi_send_telemetry_request {
+    lo_send(multicast_address, "/telemetry", "ii",
+            kTelemetryIntervalMilliseconds, atoi(kMulticast_Port));
 }
 
 - (IBAction)multi_send_remove_listeners:(NSButton *)sender {
@@ -597,14 +693,18 @@ void midiCallback(double deltatime, std::vector< unsigned char > *message, void
         node_note_nums.push_back(-1);
         node_note_nums_previous.push_back(-1);
         node_addresses.push_back(lo_address_new(address, kLocal_Port));
+        node_dests.push_back(osc_sender.addDestination(address, kLocal_Port));
+        [self publish_node_dests];
         node_idx_randperm = [self arrange_randperm:(int)node_addresses.size()];         // Random
-        node_idx_distributed = [self arrange_distributed:(int)node_addresses.size()];   // Distributed
+        voice_allocator.resize((int)node_addresses.size());                             // Distributed
         node_idx_hemispheric = [self arrange_hemispheric:(int)node_addresses.size()];   // Hemispheric
     
         NodeWindowController *win = [[NodeWindowController alloc]
                                      initWithWindowNibName:@"NodeWindowController"
                                      nodeAddress:node_addresses.back()
-                                     multicastAddress:multicast_address];
+                                     multicastAddress:multicast_address
+                                     nodeDest:node_dests.back()
+                                     multicastDest:multicast_dest];
         [node_windows addObject:win];
         
         [self print_nodes];
@@ -612,12 +712,47 @@ void midiCallback(double deltatime, std::vector< unsigned char > *message, void
     });
 }
 
+/**
+ * Give the MIDI thread a copy of node_dests. It keeps reading the copy it loaded until
+ * its next note, so node_dests can change here at any time.
+ */
+- (void)publish_node_dests {
+    std::shared_ptr<const std::vector<int> > dests(new std::vector<int>(node_dests));
+    std::atomic_store(&midi_node_dests, dests);
+}
+
+/**
+ * Report a node's envelope state to the allocator. Heartbeats arrive on the OSC server
+ * thread, but node_addresses is only modified on the main queue, so the lookup runs there.
+ */
+- (void)node_heartbeat:(const char *)address state:(int)state level:(float)level {
+    std::string hostname(address);      // The message's source is freed after the handler
+    dispatch_async(dispatch_get_main_queue(),^{
+        for (int i = 0; i < node_addresses.size(); i++) {
+            if (hostname == lo_address_get_hostname(node_addresses[i])) {
+                voice_allocator.report(i, state, level);
+                return;
+            }
+        }
+    });
+}
+
+/**
+ * Store a node's telemetry, and print it if the node dropped packets or ran slowly since
+ * its previous report.
+ */
+- (void)node_telemetry:(const char *)address report:(const NodeTelemetryReport &)report {
+    if (node_telemetry.report(address, report))
+        node_telemetry.print(address);
+}
+
 - (void)print_nodes {
     printf("available nodes:\n===========================\n");
     for (int i = 0; i < node_addresses.size(); i++) {
         printf("[%2d]    ip: %s\n", i, lo_address_get_hostname(node_addresses[i]));
         printf("[%2d]  port: %s\n", i, lo_address_get_port(node_addresses[i]));
     }
+    node_telemetry.print();
 }
 
 - (void)print_lo_address:(lo_address)address {
@@ -639,15 +774,15 @@ void midiCallback(double deltatime, std::vector< unsigned char > *message, void
 
 #pragma mark - Propagation
 - (IBAction)propagation_enabled_changed:(NSButton *)sender {
-    lo_send(multicast_address, "/propagate/enable", "i", sender.state == NSOnState ? 1 : 0);
+    osc_sender.send(multicast_dest, "/propagate/enable", "i", sender.state == NSOnState ? 1 : 0);
 }
 
 - (IBAction)follower_gate_changed:(NSButton *)sender {
-    lo_send(multicast_address, "/mod/egen/follower_gate", "i", sender.state == NSOnState ? 1 : 0);
+    osc_sender.send(multicast_dest, "/mod/egen/follower_gate", "i", sender.state == NSOnState ? 1 : 0);
 }
 
 - (IBAction)propagation_decay_changed:(NSSlider *)sender {
-    lo_send(multicast_address, "/propagate/decay", "f", sender.floatValue);
+    parameter_sender.set(multicast_dest, "/propagate/decay", sender.floatValue);
 }
 
 - (IBAction)propagation_kill_pressed:(NSButton *)sender {
@@ -709,16 +844,23 @@ void midiCallback(double deltatime, std::vector< unsigned char > *message, void
             dest_bytes[0], dest_bytes[1], dest_bytes[2], dest_bytes[3], dest_port_int);
 }
 
+/**
+ * Toggle the selected device in or out of the aggregated MIDI input. Checked devices
+ * are all read by the same input thread.
+ */
 - (IBAction)midi_device_selected:(NSPopUpButton *)sender {
     
-    if (midiIn->isPortOpen()) {
-        midiIn->closePort();
-        midiIn->cancelCallback();
-    }
+    NSMenuItem *item = [sender selectedItem];
+    unsigned int portNum = (unsigned int)[item tag];
     
-    int portNum = (int)[[sender selectedItem] tag];
-    midiIn->openPort(portNum);
-    midiIn->setCallback(&midiCallback, (__bridge void*)self);
+    if ([item state] == NSOnState) {
+        midiIn->removePort(portNum);
+        [item setState:NSOffState];
+    }
+    else {
+        midiIn->addPort(portNum);
+        [item setState:NSOnState];
+    }
     midiIn->ignoreTypes(true, true, true);
 }
 
@@ -810,6 +952,14 @@ void midiCallback(double deltatime, std::vector< unsigned char > *message, void
     else
         std::sort(node_addresses.begin(), node_addresses.end(), lo_address_greater_than_key());
     
+    // Node indices changed; look up each node's registered destination again, and
+    // rebuild allocation state from the next heartbeats
+    for (int i = 0; i < node_addresses.size(); i++)
+        node_dests[i] = osc_sender.destination(node_addresses[i]);
+    [self publish_node_dests];
+    voice_allocator.clear();
+    voice_allocator.resize((int)node_addresses.size());
+    
     [tableView reloadData];
 }
 
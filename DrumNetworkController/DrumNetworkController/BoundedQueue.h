@@ -0,0 +1,84 @@
+//
+//  BoundedQueue.h
+//  DrumNetworkController
+//
+//  Copyright © 2017 Jeff Gregorio. All rights reserved.
+//
+//  Bounded lock-free multi-producer/multi-consumer queue (Vyukov). Items are written and
+//  read in place: beginPush() claims a cell and endPush() publishes it, so producers never
+//  allocate or block.
+//
+
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+template <typename T, size_t N>     // N must be a power of 2
+class BoundedQueue {
+
+public:
+    BoundedQueue() : enqueue_pos(0), dequeue_pos(0) {
+        for (size_t i = 0; i < N; i++)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Claim a cell to write, or NULL if the queue is full
+    T *beginPush(size_t &pos) {
+        pos = enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell *cell = &cells[pos & (N - 1)];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    return &cell->item;
+            }
+            else if (dif < 0)
+                return NULL;        // Full
+            else
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    void endPush(size_t pos) {
+        cells[pos & (N - 1)].sequence.store(pos + 1, std::memory_order_release);
+    }
+
+    // Claim the oldest published cell to read, or NULL if the queue is empty
+    T *beginPop(size_t &pos) {
+        pos = dequeue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell *cell = &cells[pos & (N - 1)];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (dif == 0) {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    return &cell->item;
+            }
+            else if (dif < 0)
+                return NULL;        // Empty
+            else
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    void endPop(size_t pos) {
+        cells[pos & (N - 1)].sequence.store(pos + N, std::memory_order_release);
+    }
+
+private:
+
+    typedef struct Cell {
+        std::atomic<size_t> sequence;
+        T item;
+    } Cell;
+
+    Cell cells[N];
+    std::atomic<size_t> enqueue_pos;
+    std::atomic<size_t> dequeue_pos;
+};
+
+#endif
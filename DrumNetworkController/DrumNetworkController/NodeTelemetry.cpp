@@ -0,0 +1,139 @@
+//
+//  NodeTelemetry.cpp
+//  DrumNetworkController
+//
+//  Copyright © 2017 Jeff Gregorio. All rights reserved.
+//
+
+#include "NodeTelemetry.h"
+#include <stdio.h>
+
+#define kNodeTelemetryNumCounts (12)    // Integer fields ahead of the address counts
+
+NodeTelemetry::NodeTelemetry() {}
+
+bool NodeTelemetry::parse(const char *types, lo_arg **argv, int argc, NodeTelemetryReport &r) {
+    if (argc < kNodeTelemetryNumCounts)
+        return false;
+    for (int i = 0; i < kNodeTelemetryNumCounts; i++) {
+        if (types[i] != 'i')
+            return false;
+    }
+    int i = 0;
+    r.loops_per_s = argv[i++]->i;
+    r.osc_received = argv[i++]->i;
+    r.osc_errors = argv[i++]->i;
+    r.slip_dropped = argv[i++]->i;
+    r.prop_sent = argv[i++]->i;
+    r.prop_received = argv[i++]->i;
+    r.esp_udp_received = argv[i++]->i;
+    r.esp_udp_errors = argv[i++]->i;
+    r.esp_slip_errors = argv[i++]->i;
+    r.esp_wifi_reconnects = argv[i++]->i;
+    r.esp_loops_per_s = argv[i++]->i;
+    r.other_addresses = argv[i++]->i;
+    r.addresses.clear();
+    for (; i + 1 < argc; i += 2) {
+        if (types[i] != 's' || types[i + 1] != 'i')
+            return false;
+        r.addresses.push_back(std::make_pair(std::string(&argv[i]->s), argv[i + 1]->i));
+    }
+    return true;
+}
+
+/**
+ * Store a node's report alongside its previous one. A node's first report has nothing to
+ * compare against, so only its loop rates can flag it.
+ */
+bool NodeTelemetry::report(const char *address, const NodeTelemetryReport &r) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::map<std::string, NodeTelemetryEntry>::iterator it = nodes.find(address);
+    if (it == nodes.end()) {
+        NodeTelemetryEntry node;
+        node.previous = r;
+        node.reports = 0;
+        it = nodes.insert(std::make_pair(std::string(address), node)).first;
+    }
+    NodeTelemetryEntry &node = it->second;
+    if (node.reports > 0)
+        node.previous = node.current;
+    node.current = r;
+    node.reports++;
+    node.overloaded = overloaded(node);
+    return node.overloaded;
+}
+
+void NodeTelemetry::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    nodes.clear();
+}
+
+void NodeTelemetry::print() {
+    std::lock_guard<std::mutex> lock(mutex);
+    printf("node telemetry:\n===========================\n");
+    std::map<std::string, NodeTelemetryEntry>::iterator it;
+    for (it = nodes.begin(); it != nodes.end(); it++)
+        printNode(it->first, it->second);
+    fflush(stdout);
+}
+
+void NodeTelemetry::print(const char *address) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::map<std::string, NodeTelemetryEntry>::iterator it = nodes.find(address);
+    if (it != nodes.end())
+        printNode(it->first, it->second);
+    fflush(stdout);
+}
+
+bool NodeTelemetry::overloaded(const NodeTelemetryEntry &node) {
+    const NodeTelemetryReport &c = node.current;
+    const NodeTelemetryReport &p = node.previous;
+    return c.osc_errors > p.osc_errors ||
+           c.slip_dropped > p.slip_dropped ||
+           c.esp_udp_errors > p.esp_udp_errors ||
+           c.esp_slip_errors > p.esp_slip_errors ||
+           c.esp_wifi_reconnects > p.esp_wifi_reconnects ||
+           c.loops_per_s < kNodeTelemetryMinLoopsPerSecond ||
+           c.esp_loops_per_s < kNodeTelemetryMinEspLoopsPerSecond;
+}
+
+/**
+ * Print a node's counts since its previous report, and the busiest address. Caller holds
+ * the mutex.
+ */
+void NodeTelemetry::printNode(const std::string &address, const NodeTelemetryEntry &node) {
+    const NodeTelemetryReport &c = node.current;
+    const NodeTelemetryReport &p = node.previous;
+    printf("%-15s %s rx %d err %d drop %d prop %d/%d | esp rx %d err %d/%d wifi %d | "
+           "loops/s %d esp %d\n",
+           address.c_str(), node.overloaded ? "OVERLOADED" : "ok        ",
+           c.osc_received - p.osc_received,
+           c.osc_errors - p.osc_errors,
+           c.slip_dropped - p.slip_dropped,
+           c.prop_sent - p.prop_sent,
+           c.prop_received - p.prop_received,
+           c.esp_udp_received - p.esp_udp_received,
+           c.esp_udp_errors - p.esp_udp_errors,
+           c.esp_slip_errors - p.esp_slip_errors,
+           c.esp_wifi_reconnects - p.esp_wifi_reconnects,
+           c.loops_per_s, c.esp_loops_per_s);
+
+    // An address missing from the previous report counts from zero
+    int busiest = -1;
+    int busiest_count = 0;
+    for (int i = 0; i < (int)c.addresses.size(); i++) {
+        int count = c.addresses[i].second;
+        for (int j = 0; j < (int)p.addresses.size(); j++) {
+            if (p.addresses[j].first == c.addresses[i].first) {
+                count -= p.addresses[j].second;
+                break;
+            }
+        }
+        if (count > busiest_count) {
+            busiest = i;
+            busiest_count = count;
+        }
+    }
+    if (busiest >= 0)
+        printf("%-15s busiest: %s (%d)\n", "", c.addresses[busiest].first.c_str(), busiest_count);
+}
@@ -0,0 +1,76 @@
+//
+//  NodeTelemetry.h
+//  DrumNetworkController
+//
+//  Copyright © 2017 Jeff Gregorio. All rights reserved.
+//
+//  Message plane telemetry. Each node periodically sends its Teensy's and ESP8266's
+//  counters in one /telemetry packet; counts are totals since the node booted, so the
+//  aggregator keeps each node's previous report and works with the differences. A node
+//  whose packets were dropped or failed to parse since its previous report, that
+//  reconnected to WiFi, or whose main loop ran slowly is flagged as overloaded.
+//
+
+#ifndef NODETELEMETRY_H
+#define NODETELEMETRY_H
+
+#include "lo/lo.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+
+#define kNodeTelemetryMinLoopsPerSecond (1000)      // Teensy main loop
+#define kNodeTelemetryMinEspLoopsPerSecond (100)    // ESP8266 main loop
+
+// Fields of /telemetry, in order (see send_telemetry() in DrumNode.ino)
+typedef struct NodeTelemetryReport {
+    int loops_per_s;
+    int osc_received;
+    int osc_errors;             // Teensy: incoming messages with errors
+    int slip_dropped;           // Teensy: SLIP packets dropped (queue full or too long)
+    int prop_sent;              // Propagation hops
+    int prop_received;
+    int esp_udp_received;
+    int esp_udp_errors;         // ESP: UDP packets that failed to parse as OSC
+    int esp_slip_errors;        // ESP: SLIP packets from the Teensy that failed to parse
+    int esp_wifi_reconnects;
+    int esp_loops_per_s;
+    int other_addresses;        // Messages to addresses past the Teensy's table
+    std::vector<std::pair<std::string, int> > addresses;    // Per address message counts
+} NodeTelemetryReport;
+
+class NodeTelemetry {
+
+public:
+    NodeTelemetry();
+
+    // Unpack a /telemetry message; false if it's malformed
+    static bool parse(const char *types, lo_arg **argv, int argc, NodeTelemetryReport &r);
+
+    // Store a node's report; true if the node looks overloaded
+    bool report(const char *address, const NodeTelemetryReport &r);
+    void clear();
+
+    // One line per node, with counts since the node's previous report
+    void print();
+    void print(const char *address);
+
+private:
+
+    typedef struct NodeTelemetryEntry {
+        NodeTelemetryReport current;
+        NodeTelemetryReport previous;
+        int reports;
+        bool overloaded;
+    } NodeTelemetryEntry;
+
+    bool overloaded(const NodeTelemetryEntry &node);
+    void printNode(const std::string &address, const NodeTelemetryEntry &node);
+
+    std::map<std::string, NodeTelemetryEntry> nodes;    // By hostname
+    std::mutex mutex;                   // Reports arrive on the OSC server thread
+};
+
+#endif
@@ -0,0 +1,117 @@
+//
+//  NodeVoiceAllocator.cpp
+//  DrumNetworkController
+//
+//  Copyright © 2017 Jeff Gregorio. All rights reserved.
+//
+
+#include "NodeVoiceAllocator.h"
+
+bool NodeVoiceAllocator::NodeVoiceKey::operator<(const NodeVoiceKey &k) const {
+    if (rank != k.rank)
+        return rank < k.rank;
+    if (level != k.level)
+        return level < k.level;
+    if (last_alloc != k.last_alloc)
+        return last_alloc < k.last_alloc;
+    return idx < k.idx;
+}
+
+NodeVoiceAllocator::NodeVoiceAllocator() : alloc_count(0) {}
+
+/**
+ * Grow or shrink the node list. New nodes start out idle.
+ */
+void NodeVoiceAllocator::resize(int num_nodes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    int previous = (int)nodes.size();
+    for (int i = num_nodes; i < previous; i++)
+        queue.erase(keys[i]);
+    NodeVoice idle = {kNodeEnvelopeState_Idle, 0.0f, 0, false};
+    nodes.resize(num_nodes, idle);
+    keys.resize(num_nodes);
+    for (int i = previous; i < num_nodes; i++) {
+        keys[i] = key(i);
+        queue.insert(keys[i]);
+    }
+}
+
+void NodeVoiceAllocator::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    nodes.clear();
+    keys.clear();
+    queue.clear();
+}
+
+/**
+ * Update a node's envelope state and level from its heartbeat.
+ */
+void NodeVoiceAllocator::report(int node_idx, int state, float level) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (node_idx < 0 || node_idx >= (int)nodes.size())
+        return;
+    nodes[node_idx].state = state;
+    nodes[node_idx].level = level;
+    update(node_idx);
+}
+
+/**
+ * Return the index of the node that should take the next note: idle nodes first,
+ * then the quietest releasing or sounding node, then the least recently allocated.
+ * Returns -1 if there are no nodes.
+ */
+int NodeVoiceAllocator::allocate() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queue.empty())
+        return -1;
+    return queue.begin()->idx;
+}
+
+/**
+ * Mark a node as attacking toward the given level until its next heartbeat.
+ */
+void NodeVoiceAllocator::noteOn(int node_idx, float level) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (node_idx < 0 || node_idx >= (int)nodes.size())
+        return;
+    nodes[node_idx].state = kNodeEnvelopeState_Attack;
+    nodes[node_idx].level = level;
+    nodes[node_idx].last_alloc = ++alloc_count;
+    nodes[node_idx].held = true;
+    update(node_idx);
+}
+
+void NodeVoiceAllocator::noteOff(int node_idx) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (node_idx < 0 || node_idx >= (int)nodes.size())
+        return;
+    nodes[node_idx].state = kNodeEnvelopeState_Release;
+    nodes[node_idx].held = false;
+    update(node_idx);
+}
+
+NodeVoiceAllocator::NodeVoiceKey NodeVoiceAllocator::key(int node_idx) {
+    NodeVoice &node = nodes[node_idx];
+    NodeVoiceKey k;
+    if (node.held)
+        k.rank = 3;
+    else if (node.state == kNodeEnvelopeState_Idle)
+        k.rank = 0;
+    else if (node.state == kNodeEnvelopeState_Release)
+        k.rank = 1;
+    else
+        k.rank = 2;
+    k.level = k.rank == 0 ? 0.0f : node.level;
+    k.last_alloc = node.last_alloc;
+    k.idx = node_idx;
+    return k;
+}
+
+/**
+ * Re-insert a node in the queue after its state changed. Caller holds the mutex.
+ */
+void NodeVoiceAllocator::update(int node_idx) {
+    queue.erase(keys[node_idx]);
+    keys[node_idx] = key(node_idx);
+    queue.insert(keys[node_idx]);
+}
@@ -0,0 +1,75 @@
+//
+//  NodeVoiceAllocator.h
+//  DrumNetworkController
+//
+//  Copyright © 2017 Jeff Gregorio. All rights reserved.
+//
+//  State-aware note allocation. Each node reports its busiest voice's envelope state
+//  and its loudest voice's level in a periodic /heartbeat message; new notes go to the
+//  idle or quietest node, with ties broken by least recently allocated.
+//
+
+#ifndef NODEVOICEALLOCATOR_H
+#define NODEVOICEALLOCATOR_H
+
+#include <stdint.h>
+#include <vector>
+#include <set>
+#include <mutex>
+
+// Matches EnvelopeState in DrumNode/EnvelopeGenerator.h
+typedef enum NodeEnvelopeState {
+    kNodeEnvelopeState_Idle = 0,
+    kNodeEnvelopeState_Attack,
+    kNodeEnvelopeState_Sustain,
+    kNodeEnvelopeState_Release
+} NodeEnvelopeState;
+
+class NodeVoiceAllocator {
+
+public:
+    NodeVoiceAllocator();
+
+    void resize(int num_nodes);
+    void clear();
+
+    // Envelope state reported by a node's heartbeat
+    void report(int node_idx, int state, float level);
+
+    // Note on/off bookkeeping, so back-to-back notes don't land on the same node
+    // before its next heartbeat arrives
+    int allocate();
+    void noteOn(int node_idx, float level);
+    void noteOff(int node_idx);
+
+    int count() { return (int)nodes.size(); }
+
+private:
+
+    // Priority key, ordered by (rank, level, last allocation, index)
+    typedef struct NodeVoiceKey {
+        int rank;               // 0: idle, 1: releasing, 2: attack/sustain, 3: holding a note
+        float level;            // Most recent envelope level
+        uint64_t last_alloc;    // Allocation counter value at the most recent note on
+        int idx;                // Node index
+        bool operator<(const NodeVoiceKey &k) const;
+    } NodeVoiceKey;
+
+    typedef struct NodeVoice {
+        int state;
+        float level;
+        uint64_t last_alloc;
+        bool held;
+    } NodeVoice;
+
+    NodeVoiceKey key(int node_idx);
+    void update(int node_idx);
+
+    std::vector<NodeVoice> nodes;
+    std::vector<NodeVoiceKey> keys;     // Current key of each node in the queue
+    std::set<NodeVoiceKey> queue;       // Nodes ordered by allocation priority
+    uint64_t alloc_count;
+    std::mutex mutex;                   // Heartbeats arrive on the OSC server thread
+};
+
+#endif
@@ -10,11 +10,17 @@
 #include "lo/lo.h"
 #include <vector>
 
+class ParameterSender;
+
 @interface NodeWindowController : NSWindowController {
     lo_address node_address;
     lo_address multicast_address;
     lo_address dest_address;
     std::vector<lo_address> node_addresses;
+    ParameterSender *parameter_sender;      // Coalesced slider output
+    int node_dest;                          // Registered OscSender destinations
+    int multicast_dest;
+    int dest;                               // Follows dest_address
 }
 
 @property IBOutlet NSTextField *addressTextField;
@@ -27,7 +33,9 @@
 
 - (id)initWithWindowNibName:(NSString *)windowNibName
                 nodeAddress:(lo_address)n_addr
-           multicastAddress:(lo_address)m_addr;
+           multicastAddress:(lo_address)m_addr
+                   nodeDest:(int)n_dest
+              multicastDest:(int)m_dest;
 
 - (IBAction)multicastButtonChanged:(id)sender;
 - (IBAction)mute_changed:(NSButton *)sender;
@@ -19,10 +19,15 @@
 
 - (id)initWithWindowNibName:(NSString *)windowNibName
                 nodeAddress:(lo_address)n_addr
-           multicastAddress:(lo_address)m_addr {
+           multicastAddress:(lo_address)m_addr
+                   nodeDest:(int)n_dest
+              multicastDest:(int)m_dest {
     
     node_address = dest_address = n_addr;
     multicast_address = m_addr;
+    node_dest = dest = n_dest;
+    multicast_dest = m_dest;
+    parameter_sender = [(AppDelegate *)[NSApp delegate] get_parameter_sender];
     self = [super initWithWindowNibName:windowNibName];
     if (self)
         return self;
@@ -52,10 +57,14 @@
 }
 
 - (IBAction)multicastButtonChanged:(id)sender {
-    if ([multicastButton state] == NSOnState)
+    if ([multicastButton state] == NSOnState) {
         dest_address = multicast_address;
-    else
+        dest = multicast_dest;
+    }
+    else {
         dest_address = node_address;
+        dest = node_dest;
+    }
 }
 
 - (IBAction)mute_changed:(NSButton *)sender {
@@ -109,23 +118,23 @@
 }
 
 - (IBAction)mod_lfo_rate_changed:(NSSlider *)sender {
-    lo_send(dest_address, "/mod/lfo/rate", "f", sender.floatValue);
+    parameter_sender->set(dest, "/mod/lfo/rate", sender.floatValue);
 }
 
 - (IBAction)mod_lfo_env_mod_changed:(NSSlider *)sender {
-    lo_send(dest_address, "/mod/lfo/env_mod", "f", sender.floatValue);
+    parameter_sender->set(dest, "/mod/lfo/env_mod", sender.floatValue);
 }
 
 - (IBAction)mod_env_atk_changed:(NSSlider *)sender {
-    lo_send(dest_address, "/mod/egen/atk_time", "f", sender.floatValue);
+    parameter_sender->set(dest, "/mod/egen/atk_time", sender.floatValue);
 }
 
 - (IBAction)mod_env_sus_changed:(NSSlider *)sender {
-    lo_send(dest_address, "/mod/egen/sus_level", "f", sender.floatValue);
+    parameter_sender->set(dest, "/mod/egen/sus_level", sender.floatValue);
 }
 
 - (IBAction)mod_env_rel_changed:(NSSlider *)sender {
-    lo_send(dest_address, "/mod/egen/rel_time", "f", sender.floatValue);
+    parameter_sender->set(dest, "/mod/egen/rel_time", sender.floatValue);
 }
 
 - (IBAction)mod_env_do_sus_changed:(NSButton *)sender {
@@ -162,37 +171,37 @@
 }
 
 - (IBAction)synth_vco_freq_changed:(NSSlider *)sender {
-    lo_send(dest_address, "/synth/vco/freq_", "f", sender.floatValue);
+    parameter_sender->set(dest, "/synth/vco/freq", sender.floatValue);
 }
 
 - (IBAction)synth_vco_lfo_mod_changed:(NSSlider *)sender {
-    lo_send(dest_address, "/synth/vco/lfo_mod", "f", sender.floatValue);
+    parameter_sender->set(dest, "/synth/vco/lfo_mod", sender.floatValue);
 }
 
 - (IBAction)synth_vca_lfo_mod_changed:(NSSlider *)sender {
-    lo_send(dest_address, "/synth/vca/lfo_mod", "f", sender.floatValue);
+    parameter_sender->set(dest, "/synth/vca/lfo_mod", sender.floatValue);
 }
 
 #pragma mark - Audio input
 - (IBAction)fb_gain_changed:(NSSlider *)sender {
-    lo_send(dest_address, "/fb/gain", "f", sender.floatValue);
+    parameter_sender->set(dest, "/fb/gain", sender.floatValue);
 }
 
 - (IBAction)fb_phase_changed:(NSSlider *)sender {
-    lo_send(dest_address, "/fb/phase", "f", sender.floatValue);
+    parameter_sender->set(dest, "/fb/phase", sender.floatValue);
 }
 
 - (IBAction)fb_vca_lfo_mod_changed:(NSSlider *)sender {
-    lo_send(dest_address, "/fb/vca/lfo_mod_", "f", sender.floatValue);
+    parameter_sender->set(dest, "/fb/vca/lfo_mod", sender.floatValue);
 }
 
 - (IBAction)fb_vca_env_mod_changed:(NSSlider *)sender {
-    lo_send(dest_address, "/fb/vca/env_mod_", "f", sender.floatValue);
+    parameter_sender->set(dest, "/fb/vca/env_mod", sender.floatValue);
 }
 
 #pragma mark - Mixer
 - (IBAction)mix_changed:(NSSlider *)sender {
-    lo_send(dest_address, "/mixer/synth_feedback_mix", "f", sender.floatValue);
+    parameter_sender->set(dest, "/mixer/synth_feedback_mix", sender.floatValue);
 }
 
 #pragma mark - Propagation
@@ -205,7 +214,7 @@
 }
 
 - (IBAction)propagate_decay_changed:(NSSlider *)sender {
-    lo_send(dest_address, "/propagate/decay", "f", sender.floatValue);
+    parameter_sender->set(dest, "/propagate/decay", sender.floatValue);
 }
 
 @end
@@ -0,0 +1,270 @@
+//
+//  OscSender.cpp
+//  DrumNetworkController
+//
+//  Copyright © 2017 Jeff Gregorio. All rights reserved.
+//
+
+#include "OscSender.h"
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+OscSender::OscSender() : num_dests(0), socket_fd(-1), running(false), dropped(0) {
+#ifdef __APPLE__
+    semaphore = dispatch_semaphore_create(0);
+#else
+    sem_init(&semaphore, 0, 0);
+#endif
+}
+
+OscSender::~OscSender() {
+    stop();
+#ifndef __APPLE__
+    sem_destroy(&semaphore);
+#endif
+}
+
+void OscSender::start() {
+    if (running)
+        return;
+    socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    running = true;
+    thread = std::thread(&OscSender::run, this);
+}
+
+void OscSender::stop() {
+    if (!running)
+        return;
+    running = false;
+    signal();
+    thread.join();
+    close(socket_fd);
+    socket_fd = -1;
+}
+
+/**
+ * Resolve a host/port pair to an IPv4 socket address. Only called on the main queue when
+ * the controller starts or a node is discovered, never on the MIDI thread.
+ */
+int OscSender::addDestination(const char *host, const char *port) {
+
+    addrinfo hints, *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (getaddrinfo(host, port, &hints, &result) != 0)
+        return -1;
+    sockaddr_in addr = *(sockaddr_in *)result->ai_addr;
+    freeaddrinfo(result);
+
+    std::lock_guard<std::mutex> lock(dest_mutex);
+    int i = findDestination(addr);
+    if (i >= 0)
+        return i;
+    int n = num_dests.load();
+    if (n == kOscMaxDestinations)
+        return -1;
+    dests[n] = addr;
+    num_dests.store(n + 1, std::memory_order_release);
+    return n;
+}
+
+int OscSender::destination(lo_address address) {
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    if (inet_pton(AF_INET, lo_address_get_hostname(address), &addr.sin_addr) != 1)
+        return -1;
+    addr.sin_port = htons((uint16_t)atoi(lo_address_get_port(address)));
+    return findDestination(addr);
+}
+
+/**
+ * Registered destinations are never removed or changed, so they can be searched without
+ * the lock.
+ */
+int OscSender::findDestination(const sockaddr_in &addr) {
+    int n = num_dests.load(std::memory_order_acquire);
+    for (int i = 0; i < n; i++) {
+        if (dests[i].sin_addr.s_addr == addr.sin_addr.s_addr && dests[i].sin_port == addr.sin_port)
+            return i;
+    }
+    return -1;
+}
+
+/**
+ * Write an OSC string (null terminated, padded to a multiple of four bytes).
+ */
+static bool write_osc_string(char *buf, uint32_t &size, const char *str) {
+    uint32_t len = (uint32_t)strlen(str) + 1;
+    uint32_t padded = (len + 3) & ~3;
+    if (size + padded > kOscPacketMaxBytes)
+        return false;
+    memcpy(buf + size, str, len);
+    memset(buf + size + len, 0, padded - len);
+    size += padded;
+    return true;
+}
+
+static bool write_osc_int32(char *buf, uint32_t &size, uint32_t value) {
+    if (size + 4 > kOscPacketMaxBytes)
+        return false;
+    value = htonl(value);
+    memcpy(buf + size, &value, 4);
+    size += 4;
+    return true;
+}
+
+bool OscSender::send(int dest, const char *path, const char *types, ...) {
+
+    if (dest < 0 || dest >= num_dests.load(std::memory_order_acquire)) {
+        dropped++;
+        return false;
+    }
+
+    size_t pos;
+    OscPacket *packet = queue.beginPush(pos);
+    if (!packet) {
+        dropped++;
+        return false;
+    }
+
+    char tags[64] = ",";
+    if (types)
+        strncat(tags, types, sizeof(tags) - 2);
+
+    packet->dest = dest;
+    packet->size = 0;
+    bool ok = write_osc_string(packet->data, packet->size, path) &&
+              write_osc_string(packet->data, packet->size, tags);
+
+    va_list args;
+    va_start(args, types);
+    for (const char *t = types; ok && t && *t; t++) {
+        switch (*t) {
+            case 'i':
+                ok = write_osc_int32(packet->data, packet->size, (uint32_t)va_arg(args, int));
+                break;
+            case 'f': {
+                float f = (float)va_arg(args, double);
+                uint32_t bits;
+                memcpy(&bits, &f, 4);
+                ok = write_osc_int32(packet->data, packet->size, bits);
+                break;
+            }
+            case 's':
+                ok = write_osc_string(packet->data, packet->size, va_arg(args, const char *));
+                break;
+            default:
+                ok = false;
+                break;
+        }
+    }
+    va_end(args);
+
+    // A packet that didn't serialize still has to release its cell; send it empty
+    if (!ok) {
+        packet->size = 0;
+        dropped++;
+    }
+    queue.endPush(pos);
+    signal();
+    return ok;
+}
+
+bool OscSender::sendBundle(int dest, lo_bundle bundle) {
+
+    if (dest < 0 || dest >= num_dests.load(std::memory_order_acquire) ||
+        lo_bundle_length(bundle) > kOscPacketMaxBytes) {
+        dropped++;
+        return false;
+    }
+
+    size_t pos;
+    OscPacket *packet = queue.beginPush(pos);
+    if (!packet) {
+        dropped++;
+        return false;
+    }
+
+    size_t size = 0;
+    packet->dest = dest;
+    lo_bundle_serialise(bundle, packet->data, &size);
+    packet->size = (uint32_t)size;
+    queue.endPush(pos);
+    signal();
+    return true;
+}
+
+/**
+ * Sender thread. Sleeps until packets are queued, then drains the queue in batches.
+ */
+void OscSender::run() {
+
+    OscPacket *batch[kOscSendBatchSize];
+    size_t batch_pos[kOscSendBatchSize];
+
+    while (running) {
+        wait();
+        for (;;) {
+            int n = 0;
+            while (n < kOscSendBatchSize && (batch[n] = queue.beginPop(batch_pos[n])))
+                n++;
+            if (n == 0)
+                break;
+
+#if defined(__linux__)
+            mmsghdr msgs[kOscSendBatchSize];
+            iovec iovs[kOscSendBatchSize];
+            int m = 0;
+            for (int i = 0; i < n; i++) {
+                if (batch[i]->size == 0)
+                    continue;
+                iovs[m].iov_base = batch[i]->data;
+                iovs[m].iov_len = batch[i]->size;
+                memset(&msgs[m], 0, sizeof(mmsghdr));
+                msgs[m].msg_hdr.msg_name = &dests[batch[i]->dest];
+                msgs[m].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+                msgs[m].msg_hdr.msg_iov = &iovs[m];
+                msgs[m].msg_hdr.msg_iovlen = 1;
+                m++;
+            }
+            for (int sent = 0; sent < m; ) {
+                int r = sendmmsg(socket_fd, msgs + sent, m - sent, 0);
+                if (r <= 0)
+                    break;
+                sent += r;
+            }
+#else
+            for (int i = 0; i < n; i++) {
+                if (batch[i]->size == 0)
+                    continue;
+                sendto(socket_fd, batch[i]->data, batch[i]->size, 0,
+                       (sockaddr *)&dests[batch[i]->dest], sizeof(sockaddr_in));
+            }
+#endif
+            for (int i = 0; i < n; i++)
+                queue.endPop(batch_pos[i]);
+        }
+    }
+}
+
+void OscSender::wait() {
+#ifdef __APPLE__
+    dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+#else
+    while (sem_wait(&semaphore) != 0) {}
+#endif
+}
+
+void OscSender::signal() {
+#ifdef __APPLE__
+    dispatch_semaphore_signal(semaphore);
+#else
+    sem_post(&semaphore);
+#endif
+}
@@ -0,0 +1,92 @@
+//
+//  OscSender.h
+//  DrumNetworkController
+//
+//  Copyright © 2017 Jeff Gregorio. All rights reserved.
+//
+//  Asynchronous OSC output. Callers (the MIDI input thread, UI actions, the parameter
+//  flush timer) serialize packets straight into a bounded lock-free queue; a dedicated
+//  sender thread drains it with sendto/sendmmsg. Destination addresses are resolved
+//  once when registered (on the main queue), so nothing on the calling side touches the
+//  network.
+//
+
+#ifndef OSCSENDER_H
+#define OSCSENDER_H
+
+#include "lo/lo.h"
+#include "BoundedQueue.h"
+#include <stdint.h>
+#include <netinet/in.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#ifdef __APPLE__
+#include <dispatch/dispatch.h>
+#else
+#include <semaphore.h>
+#endif
+
+#define kOscPacketMaxBytes (512)
+#define kOscSendQueueSize (1024)        // Must be power of 2
+#define kOscMaxDestinations (256)
+#define kOscSendBatchSize (32)          // Packets per sendmmsg() call (Linux)
+
+typedef struct OscPacket {
+    int dest;                           // Destination id from addDestination()
+    uint32_t size;
+    char data[kOscPacketMaxBytes];
+} OscPacket;
+
+class OscSender {
+
+public:
+    OscSender();
+    ~OscSender();
+
+    void start();
+    void stop();
+
+    // Resolve and register a destination, returning its id (or the id of an identical
+    // destination registered earlier). Returns -1 on failure.
+    int addDestination(const char *host, const char *port);
+
+    // Id of a registered destination with a numeric host, without resolving; -1 if the
+    // address wasn't registered
+    int destination(lo_address address);
+
+    // Serialize and enqueue. Types may contain 'i', 'f' and 's'. Return false if the
+    // queue is full or the packet doesn't fit; the packet is dropped in that case.
+    bool send(int dest, const char *path, const char *types, ...);
+    bool sendBundle(int dest, lo_bundle bundle);
+
+    int droppedCount() { return dropped.load(); }
+
+private:
+
+    int findDestination(const sockaddr_in &addr);
+
+    void run();
+    void wait();
+    void signal();
+
+    BoundedQueue<OscPacket, kOscSendQueueSize> queue;   // One consumer in practice
+
+    sockaddr_in dests[kOscMaxDestinations];
+    std::atomic<int> num_dests;
+    std::mutex dest_mutex;              // Serializes addDestination() only
+
+    int socket_fd;
+    std::thread thread;
+    std::atomic<bool> running;
+    std::atomic<int> dropped;
+
+#ifdef __APPLE__
+    dispatch_semaphore_t semaphore;
+#else
+    sem_t semaphore;
+#endif
+};
+
+#endif
@@ -0,0 +1,173 @@
+//
+//  ParameterSender.cpp
+//  DrumNetworkController
+//
+//  Copyright © 2017 Jeff Gregorio. All rights reserved.
+//
+
+#include "ParameterSender.h"
+#include <string.h>
+
+ParameterSender::ParameterSender() : dropped(0), output(NULL) {
+    setDefaultMaxRate(kParameterDefaultMaxRateHz);
+}
+
+/**
+ * Queue a value for the next flush. Called from the MIDI thread, so it only copies into
+ * a preallocated cell.
+ */
+bool ParameterSender::set(int dest, const char *path, float value) {
+    size_t len = strlen(path);
+    size_t pos;
+    ParameterUpdate *update;
+    if (dest < 0 || len >= kParameterPathMaxBytes || !(update = updates.beginPush(pos))) {
+        dropped++;
+        return false;
+    }
+    update->dest = dest;
+    update->value = value;
+    memcpy(update->path, path, len + 1);
+    updates.endPush(pos);
+    return true;
+}
+
+/**
+ * Remove a destination's parameters, including values not yet sent, and re-index the
+ * rest.
+ */
+void ParameterSender::removeDestination(int dest) {
+    collect();
+    std::vector<Parameter> kept;
+    for (int i = 0; i < params.size(); i++) {
+        if (params[i].dest != dest)
+            kept.push_back(params[i]);
+    }
+    params.swap(kept);
+    param_idx.clear();
+    for (int i = 0; i < params.size(); i++)
+        param_idx[std::make_pair(params[i].dest, params[i].path)] = i;
+}
+
+void ParameterSender::setMaxRate(const char *path, double rate_hz) {
+    path_min_interval_s[path] = rate_hz > 0.0 ? 1.0 / rate_hz : 0.0;
+}
+
+void ParameterSender::setDefaultMaxRate(double rate_hz) {
+    default_min_interval_s = rate_hz > 0.0 ? 1.0 / rate_hz : 0.0;
+}
+
+void ParameterSender::setOutput(OscSender *sender) {
+    output = sender;
+}
+
+/**
+ * Move queued values into the parameter table, the latest value for a destination/path
+ * pair winning. A pair seen for the first time is added here, off the MIDI thread.
+ */
+void ParameterSender::collect() {
+    size_t pos;
+    ParameterUpdate *update;
+    while ((update = updates.beginPop(pos))) {
+        std::pair<int, std::string> key(update->dest, update->path);
+        std::map<std::pair<int, std::string>, int>::iterator it = param_idx.find(key);
+        if (it == param_idx.end()) {
+            Parameter p;
+            p.dest = update->dest;
+            p.path = update->path;
+            p.last_sent = Clock::time_point();
+            it = param_idx.insert(std::make_pair(key, (int)params.size())).first;
+            params.push_back(p);
+        }
+        params[it->second].value = update->value;
+        params[it->second].changed = true;
+        updates.endPop(pos);
+    }
+}
+
+/**
+ * Group changed parameters whose rate limit has elapsed by destination and send each
+ * group in as few bundles as fit in an OscSender packet. A parameter stays changed until
+ * a bundle containing it is queued, so values in a bundle the sender couldn't take are
+ * sent at the next flush.
+ */
+void ParameterSender::flush() {
+
+    collect();
+    if (!output)
+        return;
+
+    std::vector<int> dests;
+    std::vector<std::vector<int> > due;     // Parameter indices per destination
+    Clock::time_point now = Clock::now();
+
+    for (int i = 0; i < params.size(); i++) {
+        Parameter &p = params[i];
+        if (!p.changed)
+            continue;
+        std::chrono::duration<double> elapsed = now - p.last_sent;
+        if (elapsed.count() < minInterval(p.path))
+            continue;
+
+        int b;
+        for (b = 0; b < dests.size() && dests[b] != p.dest; b++) {}
+        if (b == dests.size()) {
+            dests.push_back(p.dest);
+            due.push_back(std::vector<int>());
+        }
+        due[b].push_back(i);
+    }
+
+    for (int b = 0; b < dests.size(); b++) {
+        std::vector<int> bundled;
+        size_t size = kOscBundleHeaderBytes;
+        for (int k = 0; k < due[b].size(); k++) {
+            size_t bytes = bundledFloatBytes(params[due[b][k]].path);
+            if (!bundled.empty() && size + bytes > kOscPacketMaxBytes) {
+                sendBundle(dests[b], bundled, now);
+                bundled.clear();
+                size = kOscBundleHeaderBytes;
+            }
+            bundled.push_back(due[b][k]);
+            size += bytes;
+        }
+        sendBundle(dests[b], bundled, now);
+    }
+}
+
+/**
+ * Send parameters as one bundle, marking them sent if the sender queued it.
+ */
+bool ParameterSender::sendBundle(int dest, const std::vector<int> &indices,
+                                 Clock::time_point now) {
+    lo_bundle bundle = lo_bundle_new(LO_TT_IMMEDIATE);
+    for (int k = 0; k < indices.size(); k++) {
+        lo_message msg = lo_message_new();
+        lo_message_add_float(msg, params[indices[k]].value);
+        lo_bundle_add_message(bundle, params[indices[k]].path.c_str(), msg);
+    }
+    bool sent = output->sendBundle(dest, bundle);
+    lo_bundle_free_recursive(bundle);
+    if (sent) {
+        for (int k = 0; k < indices.size(); k++) {
+            params[indices[k]].changed = false;
+            params[indices[k]].last_sent = now;
+        }
+    }
+    return sent;
+}
+
+/**
+ * Bytes a float message adds to a bundle: its element size, padded path, ",f" type tags
+ * and value.
+ */
+size_t ParameterSender::bundledFloatBytes(const std::string &path) {
+    return 4 + ((path.size() + 4) & ~3) + 4 + 4;
+}
+
+/**
+ * Minimum time between sends for a path.
+ */
+double ParameterSender::minInterval(const std::string &path) {
+    std::map<std::string, double>::iterator it = path_min_interval_s.find(path);
+    return it == path_min_interval_s.end() ? default_min_interval_s : it->second;
+}
@@ -0,0 +1,90 @@
+//
+//  ParameterSender.h
+//  DrumNetworkController
+//
+//  Copyright © 2017 Jeff Gregorio. All rights reserved.
+//
+//  Latest-value-wins cache for continuous OSC parameters (MIDI CC mappings and node
+//  window sliders). Values are queued as they arrive, without locks or allocation, and
+//  collected and flushed on the main queue at a fixed tick, with the changed parameters
+//  for a destination packed into as few OSC bundles as fit in a packet. Each path can be
+//  limited to a maximum send rate.
+//
+
+#ifndef PARAMETERSENDER_H
+#define PARAMETERSENDER_H
+
+#include "OscSender.h"
+#include "BoundedQueue.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+#include <chrono>
+
+#define kParameterDefaultMaxRateHz (50.0)
+#define kParameterQueueSize (256)       // Must be power of 2
+#define kParameterPathMaxBytes (64)
+#define kOscBundleHeaderBytes (16)      // "#bundle" and the time tag
+
+class ParameterSender {
+
+public:
+    ParameterSender();
+
+    // Queue the most recent value for a destination/path pair. Destinations are OscSender
+    // ids resolved when nodes are registered. Safe from any thread; returns false if the
+    // queue is full or the path is too long.
+    bool set(int dest, const char *path, float value);
+
+    // The remaining methods are called on the main queue
+
+    // Drop the parameters of a destination that no longer exists
+    void removeDestination(int dest);
+
+    // Limit how often a path is sent (per destination). Zero removes the limit.
+    void setMaxRate(const char *path, double rate_hz);
+    void setDefaultMaxRate(double rate_hz);
+
+    void setOutput(OscSender *sender);
+
+    // Collect queued values, then send changed values that are due, bundled per
+    // destination
+    void flush();
+
+    int droppedCount() { return dropped.load(); }
+
+private:
+
+    typedef std::chrono::steady_clock Clock;
+
+    typedef struct ParameterUpdate {
+        int dest;
+        float value;
+        char path[kParameterPathMaxBytes];
+    } ParameterUpdate;
+
+    typedef struct Parameter {
+        int dest;
+        std::string path;
+        float value;
+        bool changed;
+        Clock::time_point last_sent;
+    } Parameter;
+
+    void collect();
+    bool sendBundle(int dest, const std::vector<int> &indices, Clock::time_point now);
+    static size_t bundledFloatBytes(const std::string &path);
+    double minInterval(const std::string &path);
+
+    BoundedQueue<ParameterUpdate, kParameterQueueSize> updates;
+    std::atomic<int> dropped;
+
+    std::vector<Parameter> params;
+    std::map<std::pair<int, std::string>, int> param_idx;
+    std::map<std::string, double> path_min_interval_s;
+    double default_min_interval_s;
+    OscSender *output;
+};
+
+#endif
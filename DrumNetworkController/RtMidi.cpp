@@ -289,8 +289,9 @@ MidiInApi :: MidiInApi( unsigned int queueSizeLimit )
 
 MidiInApi :: ~MidiInApi( void )
 {
-  // Delete the MIDI queue.
+  // Delete the MIDI queues.
   if ( inputData_.queue.ringSize > 0 ) delete [] inputData_.queue.ring;
+  if ( inputData_.inlineQueue.ring ) delete [] inputData_.inlineQueue.ring;
 }
 
 void MidiInApi :: setCallback( RtMidiIn::RtMidiCallback callback, void *userData )
@@ -321,8 +322,98 @@ void MidiInApi :: cancelCallback()
   }
 
   inputData_.userCallback = 0;
+  inputData_.viewCallback = 0;
   inputData_.userData = 0;
   inputData_.usingCallback = false;
+  inputData_.usingInline = false;
+}
+
+void MidiInApi :: setViewCallback( RtMidiIn::RtMidiViewCallback callback, void *userData )
+{
+  if ( inputData_.usingCallback ) {
+    errorString_ = "MidiInApi::setViewCallback: a callback function is already set!";
+    error( RtMidiError::WARNING, errorString_ );
+    return;
+  }
+
+  if ( !callback ) {
+    errorString_ = "RtMidiIn::setViewCallback: callback function value is invalid!";
+    error( RtMidiError::WARNING, errorString_ );
+    return;
+  }
+
+  inputData_.inlineMessage.size = 0;
+  inputData_.inlineMessage.overflow = false;
+  inputData_.viewCallback = callback;
+  inputData_.userData = userData;
+  inputData_.usingInline = true;
+  inputData_.usingCallback = true;
+}
+
+void MidiInApi :: setInlineQueue( bool enable )
+{
+  if ( inputData_.usingCallback ) {
+    errorString_ = "RtMidiIn::setInlineQueue: a user callback is currently set for this port.";
+    error( RtMidiError::WARNING, errorString_ );
+    return;
+  }
+
+  if ( enable && !inputData_.inlineQueue.ring ) {
+    inputData_.inlineQueue.ringSize = inputData_.queue.ringSize + 1;
+    inputData_.inlineQueue.ring = new InlineMessage[ inputData_.inlineQueue.ringSize ];
+  }
+
+  inputData_.inlineMessage.size = 0;
+  inputData_.inlineMessage.overflow = false;
+  inputData_.usingInline = enable;
+}
+
+void MidiInApi :: setRealtimeInput( bool enable, int priority )
+{
+  inputData_.realtime = enable;
+  inputData_.realtimePriority = priority;
+}
+
+void MidiInApi :: appendInlineBytes( RtMidiInData *data, const unsigned char *bytes, size_t nBytes )
+{
+  InlineMessage& message = data->inlineMessage;
+  if ( message.overflow ) return;
+  if ( message.size + nBytes > RTMIDI_INLINE_MESSAGE_SIZE ) {
+    message.overflow = true;
+    return;
+  }
+  for ( size_t i=0; i<nBytes; ++i )
+    message.bytes[message.size++] = bytes[i];
+}
+
+void MidiInApi :: deliverInlineMessage( RtMidiInData *data, double timeStamp, int source )
+{
+  InlineMessage& message = data->inlineMessage;
+  if ( message.size > 0 && !message.overflow ) {
+    if ( data->viewCallback ) {
+      data->viewCallback( timeStamp, message.bytes, message.size, source, data->userData );
+    }
+    else if ( data->inlineQueue.ring ) {
+      // Single producer: only this thread writes back.
+      InlineQueue& queue = data->inlineQueue;
+      unsigned int back = queue.back.load( std::memory_order_relaxed );
+      unsigned int next = back + 1;
+      if ( next == queue.ringSize ) next = 0;
+      if ( next != queue.front.load( std::memory_order_acquire ) ) {
+        InlineMessage& slot = queue.ring[back];
+        for ( unsigned int i=0; i<message.size; ++i )
+          slot.bytes[i] = message.bytes[i];
+        slot.size = message.size;
+        slot.timeStamp = timeStamp;
+        slot.source = source;
+        queue.back.store( next, std::memory_order_release );
+      }
+      else
+        std::cerr << "\nMidiInApi: inline message queue limit reached!!\n\n";
+    }
+  }
+  message.size = 0;
+  message.overflow = false;
 }
 
 void MidiInApi :: ignoreTypes( bool midiSysex, bool midiTime, bool midiSense )
@@ -357,6 +448,48 @@ double MidiInApi :: getMessage( std::vector<unsigned char> *message )
   return deltaTime;
 }
 
+double MidiInApi :: getMessage( unsigned char *message, size_t *size, int *source )
+{
+  size_t capacity = *size;
+  *size = 0;
+
+  if ( !inputData_.usingInline || inputData_.usingCallback ) {
+    errorString_ = "RtMidiIn::getMessage: the inline queue is not enabled for this port.";
+    error( RtMidiError::WARNING, errorString_ );
+    return 0.0;
+  }
+
+  // Single consumer: only this thread writes front.
+  InlineQueue& queue = inputData_.inlineQueue;
+  unsigned int front = queue.front.load( std::memory_order_relaxed );
+  if ( front == queue.back.load( std::memory_order_acquire ) ) return 0.0;
+
+  InlineMessage& slot = queue.ring[front];
+  if ( slot.size <= capacity ) {
+    for ( unsigned int i=0; i<slot.size; ++i )
+      message[i] = slot.bytes[i];
+    *size = slot.size;
+    if ( source ) *source = slot.source;
+  }
+  double deltaTime = slot.timeStamp;
+  if ( ++front == queue.ringSize ) front = 0;
+  queue.front.store( front, std::memory_order_release );
+
+  return deltaTime;
+}
+
+void MidiInApi :: addPort( unsigned int /*portNumber*/, const std::string /*portName*/ )
+{
+  errorString_ = "MidiInApi::addPort: adding ports is not supported by this API.";
+  error( RtMidiError::WARNING, errorString_ );
+}
+
+void MidiInApi :: removePort( unsigned int /*portNumber*/ )
+{
+  errorString_ = "MidiInApi::removePort: removing ports is not supported by this API.";
+  error( RtMidiError::WARNING, errorString_ );
+}
+
 //*********************************************************************//
 //  Common MidiOutApi Definitions
 //*********************************************************************//
@@ -386,6 +519,7 @@ MidiOutApi :: ~MidiOutApi( void )
 #include <CoreMIDI/CoreMIDI.h>
 #include <CoreAudio/HostTime.h>
 #include <CoreServices/CoreServices.h>
+#include <map>
 
 // A structure to hold variables related to the CoreMIDI API
 // implementation.
@@ -396,17 +530,23 @@ struct CoreMidiData {
   MIDIEndpointRef destinationId;
   unsigned long long lastTime;
   MIDISysexSendRequest sysexreq;
+  std::map<unsigned int, MIDIEndpointRef> sources; // connected sources by port number
 };
 
+// Sources are connected with their port number + 1 as the connection
+// reference constant; virtual destinations receive a null reference.
+#define CORE_SOURCE_REFCON( portNumber ) ( (void *)(uintptr_t)( (portNumber) + 1 ) )
+
 //*********************************************************************//
 //  API: OS-X
 //  Class Definitions: MidiInCore
 //*********************************************************************//
 
-static void midiInputCallback( const MIDIPacketList *list, void *procRef, void */*srcRef*/ )
+static void midiInputCallback( const MIDIPacketList *list, void *procRef, void *srcRef )
 {
   MidiInApi::RtMidiInData *data = static_cast<MidiInApi::RtMidiInData *> (procRef);
   CoreMidiData *apiData = static_cast<CoreMidiData *> (data->apiData);
+  int source = srcRef ? (int)( (uintptr_t) srcRef - 1 ) : -1;
 
   unsigned char status;
   unsigned short nBytes, iByte, size;
@@ -457,14 +597,21 @@ static void midiInputCallback( const MIDIPacketList *list, void *procRef, void *
       // We have a continuing, segmented sysex message.
       if ( !( data->ignoreFlags & 0x01 ) ) {
         // If we're not ignoring sysex messages, copy the entire packet.
-        for ( unsigned int j=0; j<nBytes; ++j )
-          message.bytes.push_back( packet->data[j] );
+        if ( data->usingInline )
+          MidiInApi::appendInlineBytes( data, packet->data, nBytes );
+        else {
+          for ( unsigned int j=0; j<nBytes; ++j )
+            message.bytes.push_back( packet->data[j] );
+        }
       }
       continueSysex = packet->data[nBytes-1] != 0xF7;
 
       if ( !( data->ignoreFlags & 0x01 ) && !continueSysex ) {
         // If not a continuing sysex message, invoke the user callback function or queue the message.
-        if ( data->usingCallback ) {
+        if ( data->usingInline ) {
+          MidiInApi::deliverInlineMessage( data, message.timeStamp, source );
+        }
+        else if ( data->usingCallback ) {
           RtMidiIn::RtMidiCallback callback = (RtMidiIn::RtMidiCallback) data->userCallback;
           callback( message.timeStamp, &message.bytes, data->userData );
         }
@@ -523,12 +670,21 @@ static void midiInputCallback( const MIDIPacketList *list, void *procRef, void *
         }
         else size = 1;
 
-        // Copy the MIDI data to our vector.
+        // Copy the MIDI data to our vector (or inline buffer).
         if ( size ) {
-          message.bytes.assign( &packet->data[iByte], &packet->data[iByte+size] );
+          if ( data->usingInline ) {
+            data->inlineMessage.size = 0;
+            data->inlineMessage.overflow = false;
+            MidiInApi::appendInlineBytes( data, &packet->data[iByte], size );
+          }
+          else
+            message.bytes.assign( &packet->data[iByte], &packet->data[iByte+size] );
           if ( !continueSysex ) {
             // If not a continuing sysex message, invoke the user callback function or queue the message.
-            if ( data->usingCallback ) {
+            if ( data->usingInline ) {
+              MidiInApi::deliverInlineMessage( data, message.timeStamp, source );
+            }
+            else if ( data->usingCallback ) {
               RtMidiIn::RtMidiCallback callback = (RtMidiIn::RtMidiCallback) data->userCallback;
               callback( message.timeStamp, &message.bytes, data->userData );
             }
@@ -638,7 +794,7 @@ void MidiInCore :: openPort( unsigned int portNumber, const std::string portName
   }
 
   // Make the connection.
-  result = MIDIPortConnectSource( port, endpoint, NULL );
+  result = MIDIPortConnectSource( port, endpoint, CORE_SOURCE_REFCON( portNumber ) );
   if ( result != noErr ) {
     MIDIPortDispose( port );
     MIDIClientDispose( data->client );
@@ -649,6 +805,7 @@ void MidiInCore :: openPort( unsigned int portNumber, const std::string portName
 
   // Save our api-specific port information.
   data->port = port;
+  data->sources[portNumber] = endpoint;
 
   connected_ = true;
 }
@@ -683,10 +840,68 @@ void MidiInCore :: closePort( void )
   if ( data->port ) {
     MIDIPortDispose( data->port );
   }
+  data->sources.clear();
 
   connected_ = false;
 }
 
+void MidiInCore :: addPort( unsigned int portNumber, const std::string portName )
+{
+  if ( !connected_ ) {
+    openPort( portNumber, portName );
+    return;
+  }
+
+  CoreMidiData *data = static_cast<CoreMidiData *> (apiData_);
+  if ( data->sources.count( portNumber ) ) return;
+
+  if ( data->sources.size() >= RTMIDI_MAX_INPUT_SOURCES ) {
+    errorString_ = "MidiInCore::addPort: maximum number of input ports reached.";
+    error( RtMidiError::WARNING, errorString_ );
+    return;
+  }
+
+  CFRunLoopRunInMode( kCFRunLoopDefaultMode, 0, false );
+  if ( portNumber >= MIDIGetNumberOfSources() ) {
+    std::ostringstream ost;
+    ost << "MidiInCore::addPort: the 'portNumber' argument (" << portNumber << ") is invalid.";
+    errorString_ = ost.str();
+    error( RtMidiError::INVALID_PARAMETER, errorString_ );
+    return;
+  }
+
+  MIDIEndpointRef endpoint = MIDIGetSource( portNumber );
+  if ( endpoint == 0 ) {
+    errorString_ = "MidiInCore::addPort: error getting MIDI input source reference.";
+    error( RtMidiError::DRIVER_ERROR, errorString_ );
+    return;
+  }
+
+  // All sources share the input port, so CoreMIDI delivers them on one thread.
+  OSStatus result = MIDIPortConnectSource( data->port, endpoint, CORE_SOURCE_REFCON( portNumber ) );
+  if ( result != noErr ) {
+    errorString_ = "MidiInCore::addPort: error connecting OS-X MIDI input port.";
+    error( RtMidiError::DRIVER_ERROR, errorString_ );
+    return;
+  }
+
+  data->sources[portNumber] = endpoint;
+}
+
+void MidiInCore :: removePort( unsigned int portNumber )
+{
+  CoreMidiData *data = static_cast<CoreMidiData *> (apiData_);
+  std::map<unsigned int, MIDIEndpointRef>::iterator it = data->sources.find( portNumber );
+  if ( it == data->sources.end() ) {
+    errorString_ = "MidiInCore::removePort: the port is not connected.";
+    error( RtMidiError::WARNING, errorString_ );
+    return;
+  }
+
+  MIDIPortDisconnectSource( data->port, it->second );
+  data->sources.erase( it );
+}
+
 unsigned int MidiInCore :: getPortCount()
 {
   CFRunLoopRunInMode( kCFRunLoopDefaultMode, 0, false );
@@ -1094,6 +1309,14 @@ void MidiOutCore :: sendMessage( std::vector<unsigned char> *message )
 // ALSA header file.
 #include <alsa/asoundlib.h>
 
+// A sequencer port subscribed to the input port, tagged with its
+// RtMidi port number (-1 marks a free slot).
+struct AlsaMidiSource {
+  snd_seq_addr_t addr;
+  int portNumber;
+  snd_seq_port_subscribe_t *subscription;
+};
+
 // A structure to hold variables related to the ALSA API
 // implementation.
 struct AlsaMidiData {
@@ -1109,6 +1332,7 @@ struct AlsaMidiData {
   unsigned long long lastTime;
   int queue_id; // an input queue is needed to get timestamped events
   int trigger_fds[2];
+  AlsaMidiSource sources[RTMIDI_MAX_INPUT_SOURCES];
 };
 
 #define PORT_TYPE( pinfo, bits ) ((snd_seq_port_info_get_capability(pinfo) & (bits)) == (bits))
@@ -1118,22 +1342,55 @@ struct AlsaMidiData {
 //  Class Definitions: MidiInAlsa
 //*********************************************************************//
 
+// Return the port number of the subscription an event arrived on, or
+// -1 for events sent directly to a virtual port.  All subscribed
+// ports share the client's sequencer handle, so events from every
+// device arrive on this one thread in time stamp order.
+static int alsaEventSource( AlsaMidiData *apiData, const snd_seq_event_t *ev )
+{
+  for ( int i=0; i<RTMIDI_MAX_INPUT_SOURCES; ++i ) {
+    const AlsaMidiSource& src = apiData->sources[i];
+    if ( src.portNumber >= 0 && src.addr.client == ev->source.client && src.addr.port == ev->source.port )
+      return src.portNumber;
+  }
+  return -1;
+}
+
+// Block until the sequencer has input or the trigger pipe is written.
+static void alsaWaitForInput( struct pollfd *poll_fds, int poll_fd_count )
+{
+  if ( poll( poll_fds, poll_fd_count, -1) >= 0 ) {
+    if ( poll_fds[0].revents & POLLIN ) {
+      bool dummy;
+      int res = read( poll_fds[0].fd, &dummy, sizeof(dummy) );
+      (void) res;
+    }
+  }
+}
+
 static void *alsaMidiHandler( void *ptr )
 {
   MidiInApi::RtMidiInData *data = static_cast<MidiInApi::RtMidiInData *> (ptr);
   AlsaMidiData *apiData = static_cast<AlsaMidiData *> (data->apiData);
 
+  // In real-time mode, events are read until the non-blocking input
+  // runs dry rather than checking for pending input before each one,
+  // the decode buffer is sized for a full sysex chunk up front, and
+  // time stamps keep the queue's nanosecond resolution.
+  const bool realtime = data->realtime;
+
   long nBytes;
   unsigned long long time, lastTime;
   bool continueSysex = false;
   bool doDecode = false;
+  int source = -1;
   MidiInApi::MidiMessage message;
   int poll_fd_count;
   struct pollfd *poll_fds;
 
   snd_seq_event_t *ev;
   int result;
-  apiData->bufferSize = 32;
+  apiData->bufferSize = realtime ? 256 : 32;
   result = snd_midi_event_new( 0, &apiData->coder );
   if ( result < 0 ) {
     data->doInput = false;
@@ -1159,21 +1416,20 @@ static void *alsaMidiHandler( void *ptr )
 
   while ( data->doInput ) {
 
-    if ( snd_seq_event_input_pending( apiData->seq, 1 ) == 0 ) {
+    if ( !realtime && snd_seq_event_input_pending( apiData->seq, 1 ) == 0 ) {
       // No data pending
-      if ( poll( poll_fds, poll_fd_count, -1) >= 0 ) {
-        if ( poll_fds[0].revents & POLLIN ) {
-          bool dummy;
-          int res = read( poll_fds[0].fd, &dummy, sizeof(dummy) );
-          (void) res;
-        }
-      }
+      alsaWaitForInput( poll_fds, poll_fd_count );
       continue;
     }
 
-    // If here, there should be data.
+    // If here, there should be data (in real-time mode, keep reading
+    // until the input reports it's empty).
     result = snd_seq_event_input( apiData->seq, &ev );
-    if ( result == -ENOSPC ) {
+    if ( result == -EAGAIN ) {
+      alsaWaitForInput( poll_fds, poll_fd_count );
+      continue;
+    }
+    else if ( result == -ENOSPC ) {
       std::cerr << "\nMidiInAlsa::alsaMidiHandler: MIDI input buffer overrun!\n\n";
       continue;
     }
@@ -1185,9 +1441,14 @@ static void *alsaMidiHandler( void *ptr )
 
     // This is a bit weird, but we now have to decode an ALSA MIDI
     // event (back) into MIDI bytes.  We'll ignore non-MIDI types.
-    if ( !continueSysex ) message.bytes.clear();
+    if ( !continueSysex ) {
+      message.bytes.clear();
+      data->inlineMessage.size = 0;
+      data->inlineMessage.overflow = false;
+    }
 
     doDecode = false;
+    source = alsaEventSource( apiData, ev );
     switch ( ev->type ) {
 
     case SND_SEQ_EVENT_PORT_SUBSCRIBED:
@@ -1249,12 +1510,14 @@ static void *alsaMidiHandler( void *ptr )
         // than this, they are segmented into 256 byte chunks.  So,
         // we'll watch for this and concatenate sysex chunks into a
         // single sysex message if necessary.
-        if ( !continueSysex )
+        if ( data->usingInline )
+          MidiInApi::appendInlineBytes( data, buffer, nBytes );
+        else if ( !continueSysex )
           message.bytes.assign( buffer, &buffer[nBytes] );
         else
           message.bytes.insert( message.bytes.end(), buffer, &buffer[nBytes] );
 
-        continueSysex = ( ( ev->type == SND_SEQ_EVENT_SYSEX ) && ( message.bytes.back() != 0xF7 ) );
+        continueSysex = ( ( ev->type == SND_SEQ_EVENT_SYSEX ) && ( buffer[nBytes-1] != 0xF7 ) );
         if ( !continueSysex ) {
 
           // Calculate the time stamp:
@@ -1266,14 +1529,17 @@ static void *alsaMidiHandler( void *ptr )
 
           // Method 2: Use the ALSA sequencer event time data.
           // (thanks to Pedro Lopez-Cabanillas!).
-          time = ( ev->time.time.tv_sec * 1000000 ) + ( ev->time.time.tv_nsec/1000 );
+          if ( realtime )
+            time = ( ev->time.time.tv_sec * 1000000000ULL ) + ev->time.time.tv_nsec;
+          else
+            time = ( ev->time.time.tv_sec * 1000000 ) + ( ev->time.time.tv_nsec/1000 );
           lastTime = time;
           time -= apiData->lastTime;
           apiData->lastTime = lastTime;
           if ( data->firstMessage == true )
             data->firstMessage = false;
           else
-            message.timeStamp = time * 0.000001;
+            message.timeStamp = realtime ? time * 0.000000001 : time * 0.000001;
         }
         else {
 #if defined(__RTMIDI_DEBUG__)
@@ -1284,6 +1550,11 @@ static void *alsaMidiHandler( void *ptr )
     }
 
     snd_seq_free_event( ev );
+    if ( data->usingInline ) {
+      if ( !continueSysex )
+        MidiInApi::deliverInlineMessage( data, message.timeStamp, source );
+      continue;
+    }
     if ( message.bytes.size() == 0 || continueSysex ) continue;
 
     if ( data->usingCallback ) {
@@ -1341,6 +1612,39 @@ MidiInAlsa :: ~MidiInAlsa()
   delete data;
 }
 
+int MidiInAlsa :: startInputThread( void )
+{
+  AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+  pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+
+  inputData_.doInput = true;
+  int err;
+  if ( inputData_.realtime ) {
+    pthread_attr_t rtattr;
+    struct sched_param param;
+    pthread_attr_init(&rtattr);
+    pthread_attr_setdetachstate(&rtattr, PTHREAD_CREATE_JOINABLE);
+    pthread_attr_setinheritsched(&rtattr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&rtattr, SCHED_FIFO);
+    param.sched_priority = inputData_.realtimePriority;
+    pthread_attr_setschedparam(&rtattr, &param);
+    err = pthread_create(&data->thread, &rtattr, alsaMidiHandler, &inputData_);
+    pthread_attr_destroy(&rtattr);
+    if ( err == EPERM || err == EINVAL ) {
+      errorString_ = "MidiInAlsa::startInputThread: unable to use real-time scheduling, using normal priority.";
+      error( RtMidiError::WARNING, errorString_ );
+      err = pthread_create(&data->thread, &attr, alsaMidiHandler, &inputData_);
+    }
+  }
+  else
+    err = pthread_create(&data->thread, &attr, alsaMidiHandler, &inputData_);
+  pthread_attr_destroy(&attr);
+  return err;
+}
+
 void MidiInAlsa :: initialize( const std::string& clientName )
 {
   // Set up the ALSA sequencer client.
@@ -1365,6 +1669,10 @@ void MidiInAlsa :: initialize( const std::string& clientName )
   data->thread = data->dummy_thread_id;
   data->trigger_fds[0] = -1;
   data->trigger_fds[1] = -1;
+  for ( int i=0; i<RTMIDI_MAX_INPUT_SOURCES; ++i ) {
+    data->sources[i].portNumber = -1;
+    data->sources[i].subscription = 0;
+  }
   apiData_ = (void *) data;
   inputData_.apiData = (void *) data;
 
@@ -1532,6 +1840,9 @@ void MidiInAlsa :: openPort( unsigned int portNumber, const std::string portName
       error( RtMidiError::DRIVER_ERROR, errorString_ );
       return;
     }
+    data->sources[0].addr = sender;
+    data->sources[0].subscription = data->subscription;
+    data->sources[0].portNumber = portNumber;
   }
 
   if ( inputData_.doInput == false ) {
@@ -1541,14 +1852,7 @@ void MidiInAlsa :: openPort( unsigned int portNumber, const std::string portName
     snd_seq_drain_output( data->seq );
 #endif
     // Start our MIDI input thread.
-    pthread_attr_t attr;
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-    pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
-
-    inputData_.doInput = true;
-    int err = pthread_create(&data->thread, &attr, alsaMidiHandler, &inputData_);
-    pthread_attr_destroy(&attr);
+    int err = startInputThread();
     if ( err ) {
       snd_seq_unsubscribe_port( data->seq, data->subscription );
       snd_seq_port_subscribe_free( data->subscription );
@@ -1603,14 +1907,7 @@ void MidiInAlsa :: openVirtualPort( std::string portName )
     snd_seq_drain_output( data->seq );
 #endif
     // Start our MIDI input thread.
-    pthread_attr_t attr;
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-    pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
-
-    inputData_.doInput = true;
-    int err = pthread_create(&data->thread, &attr, alsaMidiHandler, &inputData_);
-    pthread_attr_destroy(&attr);
+    int err = startInputThread();
     if ( err ) {
       if ( data->subscription ) {
         snd_seq_unsubscribe_port( data->seq, data->subscription );
@@ -1630,6 +1927,15 @@ void MidiInAlsa :: closePort( void )
   AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
 
   if ( connected_ ) {
+    for ( int i=0; i<RTMIDI_MAX_INPUT_SOURCES; ++i ) {
+      AlsaMidiSource& src = data->sources[i];
+      if ( src.portNumber >= 0 && src.subscription != data->subscription ) {
+        snd_seq_unsubscribe_port( data->seq, src.subscription );
+        snd_seq_port_subscribe_free( src.subscription );
+      }
+      src.portNumber = -1;
+      src.subscription = 0;
+    }
     if ( data->subscription ) {
       snd_seq_unsubscribe_port( data->seq, data->subscription );
       snd_seq_port_subscribe_free( data->subscription );
@@ -1653,6 +1959,85 @@ void MidiInAlsa :: closePort( void )
   }
 }
 
+void MidiInAlsa :: addPort( unsigned int portNumber, const std::string portName )
+{
+  if ( !connected_ ) {
+    openPort( portNumber, portName );
+    return;
+  }
+
+  AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
+  int slot = -1;
+  for ( int i=0; i<RTMIDI_MAX_INPUT_SOURCES; ++i ) {
+    if ( data->sources[i].portNumber == (int) portNumber ) return;
+    if ( slot < 0 && data->sources[i].portNumber < 0 ) slot = i;
+  }
+  if ( slot < 0 ) {
+    errorString_ = "MidiInAlsa::addPort: maximum number of input ports reached.";
+    error( RtMidiError::WARNING, errorString_ );
+    return;
+  }
+
+  snd_seq_port_info_t *src_pinfo;
+  snd_seq_port_info_alloca( &src_pinfo );
+  if ( portInfo( data->seq, src_pinfo, SND_SEQ_PORT_CAP_READ|SND_SEQ_PORT_CAP_SUBS_READ, (int) portNumber ) == 0 ) {
+    std::ostringstream ost;
+    ost << "MidiInAlsa::addPort: the 'portNumber' argument (" << portNumber << ") is invalid.";
+    errorString_ = ost.str();
+    error( RtMidiError::INVALID_PARAMETER, errorString_ );
+    return;
+  }
+
+  // Subscribe the source to our existing input port, so its events
+  // are read by the same input thread.
+  snd_seq_addr_t sender, receiver;
+  sender.client = snd_seq_port_info_get_client( src_pinfo );
+  sender.port = snd_seq_port_info_get_port( src_pinfo );
+  receiver.client = snd_seq_client_id( data->seq );
+  receiver.port = data->vport;
+
+  snd_seq_port_subscribe_t *subscription;
+  if ( snd_seq_port_subscribe_malloc( &subscription ) < 0 ) {
+    errorString_ = "MidiInAlsa::addPort: ALSA error allocation port subscription.";
+    error( RtMidiError::DRIVER_ERROR, errorString_ );
+    return;
+  }
+  snd_seq_port_subscribe_set_sender( subscription, &sender );
+  snd_seq_port_subscribe_set_dest( subscription, &receiver );
+
+  // Publish the tag before events can arrive from the new source.
+  AlsaMidiSource& src = data->sources[slot];
+  src.addr = sender;
+  src.subscription = subscription;
+  src.portNumber = portNumber;
+
+  if ( snd_seq_subscribe_port( data->seq, subscription ) ) {
+    src.portNumber = -1;
+    src.subscription = 0;
+    snd_seq_port_subscribe_free( subscription );
+    errorString_ = "MidiInAlsa::addPort: ALSA error making port connection.";
+    error( RtMidiError::DRIVER_ERROR, errorString_ );
+  }
+}
+
+void MidiInAlsa :: removePort( unsigned int portNumber )
+{
+  AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
+  for ( int i=0; i<RTMIDI_MAX_INPUT_SOURCES; ++i ) {
+    AlsaMidiSource& src = data->sources[i];
+    if ( src.portNumber != (int) portNumber ) continue;
+    snd_seq_unsubscribe_port( data->seq, src.subscription );
+    snd_seq_port_subscribe_free( src.subscription );
+    if ( src.subscription == data->subscription ) data->subscription = 0;
+    src.portNumber = -1;
+    src.subscription = 0;
+    return;
+  }
+
+  errorString_ = "MidiInAlsa::removePort: the port is not connected.";
+  error( RtMidiError::WARNING, errorString_ );
+}
+
 //*********************************************************************//
 //  API: LINUX ALSA
 //  Class Definitions: MidiOutAlsa
@@ -49,6 +49,16 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <atomic>
+
+// Capacity of the fixed-size messages used by the inline input mode
+// (see RtMidiIn::setViewCallback()).  Channel and system common
+// messages always fit; longer sysex messages are dropped in that mode.
+#define RTMIDI_INLINE_MESSAGE_SIZE 64
+
+// Maximum number of ports that can be aggregated into one input
+// (see RtMidiIn::addPort()).
+#define RTMIDI_MAX_INPUT_SOURCES 16
 
 /************************************************************************/
 /*! \class RtMidiError
@@ -210,6 +220,14 @@ class RtMidiIn : public RtMidi
   //! User callback function type definition.
   typedef void (*RtMidiCallback)( double timeStamp, std::vector<unsigned char> *message, void *userData);
 
+  //! User callback function type definition for the inline input mode.
+  /*!
+    The message bytes are only valid for the duration of the call.
+    The source is the port number the message arrived on, or -1 for
+    a virtual port.
+  */
+  typedef void (*RtMidiViewCallback)( double timeStamp, const unsigned char *message, size_t size, int source, void *userData );
+
   //! Default constructor that allows an optional api, client name and queue size.
   /*!
     An exception will be thrown if a MIDI system initialization
@@ -258,6 +276,24 @@ class RtMidiIn : public RtMidi
   */
   void openVirtualPort( const std::string portName = std::string( "RtMidi Input" ) );
 
+  //! Add an input port to this instance's connection (OS X and ALSA only).
+  /*!
+    Messages from every added port are delivered in arrival order by
+    the same input thread and, in the inline input mode, tagged with
+    the port number they came from.  If no connection is open, this
+    is equivalent to \e openPort.  Up to RTMIDI_MAX_INPUT_SOURCES ports
+    may be added.  Interleaved sysex from several ports is not
+    supported.
+
+    \param portNumber The port number to add.
+    \param portName An optional name for the application port, used if
+                    the connection has to be opened.
+  */
+  void addPort( unsigned int portNumber, const std::string portName = std::string( "RtMidi Input" ) );
+
+  //! Remove an input port added with \e addPort or \e openPort.
+  void removePort( unsigned int portNumber );
+
   //! Set a callback function to be invoked for incoming MIDI messages.
   /*!
     The callback function will be called whenever an incoming MIDI
@@ -278,6 +314,45 @@ class RtMidiIn : public RtMidi
   */
   void cancelCallback();
 
+  //! Set a callback function that receives a pointer/length view of each incoming MIDI message.
+  /*!
+    Selects the inline input mode: messages are assembled in a
+    fixed-capacity buffer of RTMIDI_INLINE_MESSAGE_SIZE bytes rather
+    than a std::vector, so steady-state input performs no heap
+    allocation.  Sysex messages longer than the buffer are dropped.
+    The view callback is cancelled with \e cancelCallback.
+
+    \param callback A callback function must be given.
+    \param userData Optionally, a pointer to additional data can be
+                    passed to the callback function whenever it is called.
+  */
+  void setViewCallback( RtMidiViewCallback callback, void *userData = 0 );
+
+  //! Queue incoming messages in a lock-free ring of fixed-capacity messages.
+  /*!
+    Selects the inline input mode without a callback.  Messages are
+    retrieved with the pointer/size variant of \e getMessage, which
+    may be called from one thread concurrently with MIDI input.  The
+    ring holds the queue size given to the constructor and is
+    allocated here, so this should be called before opening a port.
+  */
+  void setInlineQueue( bool enable = true );
+
+  //! Run MIDI input on a real-time (SCHED_FIFO) thread that drains all pending events per wakeup (ALSA only).
+  /*!
+    Event delta-times are then computed from the ALSA queue's
+    real-time clock with nanosecond resolution.  If the process
+    lacks permission for real-time scheduling, a warning is issued
+    and the thread runs at normal priority.  Takes effect when the
+    input thread is started, so this should be called before
+    opening a port.  CoreMIDI already delivers input on a real-time
+    thread and ignores this setting.
+
+    \param enable   Enable or disable real-time input.
+    \param priority The SCHED_FIFO priority of the input thread.
+  */
+  void setRealtimeInput( bool enable = true, int priority = 80 );
+
   //! Close an open MIDI connection (if one exists).
   void closePort( void );
 
@@ -317,6 +392,17 @@ class RtMidiIn : public RtMidi
   */
   double getMessage( std::vector<unsigned char> *message );
 
+  //! Copy the next message from the inline queue into a user-provided buffer and return the event delta-time in seconds.
+  /*!
+    On input, \e size holds the capacity of \e message.  On return it
+    holds the number of bytes copied, or zero if no message was
+    available (or the message didn't fit, in which case it is
+    discarded).  If \e source is given, it receives the port number
+    the message arrived on (-1 for a virtual port).  Requires
+    \e setInlineQueue.
+  */
+  double getMessage( unsigned char *message, size_t *size, int *source = 0 );
+
   //! Set an error callback function to be invoked when an error has occured.
   /*!
     The callback function will be called whenever an error has occured. It is best
@@ -472,8 +558,14 @@ class MidiInApi : public MidiApi
   virtual ~MidiInApi( void );
   void setCallback( RtMidiIn::RtMidiCallback callback, void *userData );
   void cancelCallback( void );
+  void setViewCallback( RtMidiIn::RtMidiViewCallback callback, void *userData );
+  void setInlineQueue( bool enable );
+  void setRealtimeInput( bool enable, int priority );
   virtual void ignoreTypes( bool midiSysex, bool midiTime, bool midiSense );
   double getMessage( std::vector<unsigned char> *message );
+  double getMessage( unsigned char *message, size_t *size, int *source );
+  virtual void addPort( unsigned int portNumber, const std::string portName );
+  virtual void removePort( unsigned int portNumber );
 
   // A MIDI structure used internally by the class to store incoming
   // messages.  Each message represents one and only one MIDI message.
@@ -498,6 +590,34 @@ class MidiInApi : public MidiApi
   :front(0), back(0), size(0), ringSize(0) {}
   };
 
+  // A fixed-capacity message used by the inline input mode.  Bytes
+  // that don't fit set the overflow flag and the message is dropped.
+  struct InlineMessage {
+    unsigned char bytes[RTMIDI_INLINE_MESSAGE_SIZE];
+    unsigned int size;
+    bool overflow;
+    double timeStamp;
+    int source;
+
+    // Default constructor.
+  InlineMessage()
+  :size(0), overflow(false), timeStamp(0.0), source(-1) {}
+  };
+
+  // A lock-free single-producer (input thread), single-consumer
+  // (getMessage caller) ring of inline messages.  One slot is kept
+  // empty to distinguish a full ring from an empty one.
+  struct InlineQueue {
+    std::atomic<unsigned int> front;
+    std::atomic<unsigned int> back;
+    unsigned int ringSize;
+    InlineMessage *ring;
+
+    // Default constructor.
+  InlineQueue()
+  :front(0), back(0), ringSize(0), ring(0) {}
+  };
+
   // The RtMidiInData structure is used to pass private class data to
   // the MIDI input handling function or thread.
   struct RtMidiInData {
@@ -511,14 +631,25 @@ class MidiInApi : public MidiApi
     RtMidiIn::RtMidiCallback userCallback;
     void *userData;
     bool continueSysex;
+    bool usingInline;
+    InlineQueue inlineQueue;
+    InlineMessage inlineMessage;
+    RtMidiIn::RtMidiViewCallback viewCallback;
+    bool realtime;
+    int realtimePriority;
 
     // Default constructor.
   RtMidiInData()
   : ignoreFlags(7), doInput(false), firstMessage(true),
       apiData(0), usingCallback(false), userCallback(0), userData(0),
-      continueSysex(false) {}
+      continueSysex(false), usingInline(false), viewCallback(0),
+      realtime(false), realtimePriority(0) {}
   };
 
+  // Inline mode helpers used by the API-specific input handlers.
+  static void appendInlineBytes( RtMidiInData *data, const unsigned char *bytes, size_t nBytes );
+  static void deliverInlineMessage( RtMidiInData *data, double timeStamp, int source );
+
  protected:
   RtMidiInData inputData_;
 };
@@ -545,10 +676,16 @@ inline void RtMidiIn :: closePort( void ) { rtapi_->closePort(); }
 inline bool RtMidiIn :: isPortOpen() const { return rtapi_->isPortOpen(); }
 inline void RtMidiIn :: setCallback( RtMidiCallback callback, void *userData ) { ((MidiInApi *)rtapi_)->setCallback( callback, userData ); }
 inline void RtMidiIn :: cancelCallback( void ) { ((MidiInApi *)rtapi_)->cancelCallback(); }
+inline void RtMidiIn :: setViewCallback( RtMidiViewCallback callback, void *userData ) { ((MidiInApi *)rtapi_)->setViewCallback( callback, userData ); }
+inline void RtMidiIn :: setInlineQueue( bool enable ) { ((MidiInApi *)rtapi_)->setInlineQueue( enable ); }
+inline void RtMidiIn :: setRealtimeInput( bool enable, int priority ) { ((MidiInApi *)rtapi_)->setRealtimeInput( enable, priority ); }
 inline unsigned int RtMidiIn :: getPortCount( void ) { return rtapi_->getPortCount(); }
 inline std::string RtMidiIn :: getPortName( unsigned int portNumber ) { return rtapi_->getPortName( portNumber ); }
 inline void RtMidiIn :: ignoreTypes( bool midiSysex, bool midiTime, bool midiSense ) { ((MidiInApi *)rtapi_)->ignoreTypes( midiSysex, midiTime, midiSense ); }
 inline double RtMidiIn :: getMessage( std::vector<unsigned char> *message ) { return ((MidiInApi *)rtapi_)->getMessage( message ); }
+inline double RtMidiIn :: getMessage( unsigned char *message, size_t *size, int *source ) { return ((MidiInApi *)rtapi_)->getMessage( message, size, source ); }
+inline void RtMidiIn :: addPort( unsigned int portNumber, const std::string portName ) { ((MidiInApi *)rtapi_)->addPort( portNumber, portName ); }
+inline void RtMidiIn :: removePort( unsigned int portNumber ) { ((MidiInApi *)rtapi_)->removePort( portNumber ); }
 inline void RtMidiIn :: setErrorCallback( RtMidiErrorCallback errorCallback, void *userData ) { rtapi_->setErrorCallback(errorCallback, userData); }
 
 inline RtMidi::Api RtMidiOut :: getCurrentApi( void ) throw() { return rtapi_->getCurrentApi(); }
@@ -584,6 +721,8 @@ class MidiInCore: public MidiInApi
   void closePort( void );
   unsigned int getPortCount( void );
   std::string getPortName( unsigned int portNumber );
+  void addPort( unsigned int portNumber, const std::string portName );
+  void removePort( unsigned int portNumber );
 
  protected:
   void initialize( const std::string& clientName );
@@ -664,9 +803,12 @@ class MidiInAlsa: public MidiInApi
   void closePort( void );
   unsigned int getPortCount( void );
   std::string getPortName( unsigned int portNumber );
+  void addPort( unsigned int portNumber, const std::string portName );
+  void removePort( unsigned int portNumber );
 
  protected:
   void initialize( const std::string& clientName );
+  int startInputThread( void );
 };
 
 class MidiOutAlsa: public MidiOutApi
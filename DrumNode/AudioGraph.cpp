@@ -0,0 +1,348 @@
+#include "AudioGraph.h"
+#include <stddef.h>
+#include <string.h>
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+const float AudioGraph::silence[GRAPH_BLOCK_SAMPLES] = { 0 };
+
+AudioGraph::AudioGraph() :
+  num_sources(0), num_descs(0), active(0), swap_pending(false), error("") {
+  memset(outputs, 0, sizeof(outputs));
+  for (int i = 0; i < 2; i++) {
+    programs[i].num_nodes = 0;
+    for (int c = 0; c < GRAPH_OUTPUTS; c++)
+      programs[i].outputs[c] = silence;
+  }
+}
+
+AudioGraph::~AudioGraph() { }
+
+/* === Sources === */
+
+bool AudioGraph::addFollower(const char *name, EnvelopeFollower *follower) {
+  return addSource(name, kGraphFollower, follower, NULL, NULL);
+}
+
+bool AudioGraph::addEnvelope(const char *name, EnvelopeGenerator *egen,
+                             const bool *follower_gate) {
+  return addSource(name, kGraphEnvelope, egen, follower_gate, NULL);
+}
+
+bool AudioGraph::addOscillator(const char *name, Oscillator *osc) {
+  return addSource(name, kGraphOscillator, osc, NULL, NULL);
+}
+
+bool AudioGraph::addDelay(const char *name, CircularBuffer *buffer, const float *delay_samples) {
+  return addSource(name, kGraphDelay, buffer, NULL, delay_samples);
+}
+
+bool AudioGraph::addVoices(const char *name, VoiceChannel *channel) {
+  return addSource(name, kGraphVoices, channel, NULL, NULL);
+}
+
+bool AudioGraph::addSource(const char *name, GraphNodeType type, void *object,
+                           const bool *gate, const float *param) {
+  if (num_sources == GRAPH_MAX_SOURCES)
+    return fail("too many sources");
+  Source &src = sources[num_sources++];
+  strncpy(src.name, name, GRAPH_NAME_LEN - 1);
+  src.name[GRAPH_NAME_LEN - 1] = '\0';
+  src.type = type;
+  src.object = object;
+  src.gate = gate;
+  src.param = param;
+  return true;
+}
+
+/* === Pending description === */
+
+void AudioGraph::clear() {
+  num_descs = 0;
+  memset(outputs, 0, sizeof(outputs));
+}
+
+bool AudioGraph::addNode(const char *name, const char *type, float amount,
+                         const float *amount_param) {
+
+  if (num_descs == GRAPH_MAX_NODES)
+    return fail("too many nodes");
+  if (name[0] == '\0' || strlen(name) >= GRAPH_NAME_LEN)
+    return fail("bad node name");
+  if (findNode(name) >= 0)
+    return fail("duplicate node name");
+
+  NodeDesc &d = descs[num_descs];
+  d.source = -1;
+  if (strcmp(type, "input") == 0)
+    d.type = kGraphInput;
+  else if (strcmp(type, "vca") == 0)
+    d.type = kGraphVca;
+  else if (strcmp(type, "mix") == 0)
+    d.type = kGraphMix;
+  else {
+    d.source = findSource(type);
+    if (d.source < 0)
+      return fail("unknown node type");
+    for (int i = 0; i < num_descs; i++) {
+      if (descs[i].source == d.source)
+        return fail("source already in graph");
+    }
+    d.type = sources[d.source].type;
+  }
+
+  strcpy(d.name, name);
+  memset(d.inputs, 0, sizeof(d.inputs));
+  d.amount = amount;
+  d.amount_param = amount_param;
+  num_descs++;
+  return true;
+}
+
+bool AudioGraph::connect(const char *src, const char *dst, int input) {
+  int s = findNode(src);
+  int d = findNode(dst);
+  if (s < 0 || d < 0)
+    return fail("unknown node");
+  if (input < 0 || input >= numInputs(descs[d].type))
+    return fail("bad input number");
+  strcpy(descs[d].inputs[input], descs[s].name);
+  return true;
+}
+
+bool AudioGraph::setOutput(const char *name, int channel) {
+  if (channel < 0 || channel >= GRAPH_OUTPUTS)
+    return fail("bad output channel");
+  if (findNode(name) < 0)
+    return fail("unknown node");
+  strcpy(outputs[channel], name);
+  return true;
+}
+
+/**
+ * Set the constant amount of a VCA or mix node in the description and in both compiled
+ * programs. Nodes bound to a parameter are unaffected.
+ */
+bool AudioGraph::setAmount(const char *name, float amount) {
+  bool found = false;
+  int d = findNode(name);
+  if (d >= 0) {
+    descs[d].amount = amount;
+    found = true;
+  }
+  for (int i = 0; i < 2; i++) {
+    for (int n = 0; n < programs[i].num_nodes; n++) {
+      Node &node = programs[i].nodes[n];
+      if (strcmp(node.name, name) == 0) {
+        node.amount = amount;
+        found = true;
+      }
+    }
+  }
+  return found ? true : fail("unknown node");
+}
+
+/**
+ * Resolve connections, sort the description so every node follows the nodes it reads
+ * (Kahn's algorithm), and compile it into the program that isn't running. Fails without
+ * touching the running graph if a connection is unknown or the graph has a cycle.
+ */
+bool AudioGraph::commit() {
+
+  int src_of[GRAPH_MAX_NODES][GRAPH_MAX_INPUTS];    // Description index of each input
+  int unsorted_inputs[GRAPH_MAX_NODES];
+  int output_src[GRAPH_OUTPUTS];
+
+  for (int i = 0; i < num_descs; i++) {
+    unsorted_inputs[i] = 0;
+    for (int j = 0; j < GRAPH_MAX_INPUTS; j++) {
+      src_of[i][j] = -1;
+      if (descs[i].inputs[j][0] == '\0')
+        continue;
+      src_of[i][j] = findNode(descs[i].inputs[j]);
+      if (src_of[i][j] < 0)
+        return fail("unknown input node");
+      unsorted_inputs[i]++;
+    }
+  }
+  for (int c = 0; c < GRAPH_OUTPUTS; c++) {
+    output_src[c] = outputs[c][0] == '\0' ? -1 : findNode(outputs[c]);
+    if (outputs[c][0] != '\0' && output_src[c] < 0)
+      return fail("unknown output node");
+  }
+
+  // Topological sort
+  int order[GRAPH_MAX_NODES];
+  int num_sorted = 0;
+  for (int i = 0; i < num_descs; i++) {
+    if (unsorted_inputs[i] == 0)
+      order[num_sorted++] = i;
+  }
+  for (int k = 0; k < num_sorted; k++) {
+    for (int i = 0; i < num_descs; i++) {
+      for (int j = 0; j < GRAPH_MAX_INPUTS; j++) {
+        if (src_of[i][j] == order[k] && --unsorted_inputs[i] == 0)
+          order[num_sorted++] = i;
+      }
+    }
+  }
+  if (num_sorted < num_descs)
+    return fail("graph has a cycle");
+
+  // Compile into the inactive program. Cancel any swap not yet taken first, so the
+  // program being written can't become active.
+  swap_pending = false;
+  __sync_synchronize();
+  Program &p = programs[active ^ 1];
+
+  int pos[GRAPH_MAX_NODES];             // Sorted position of each description
+  for (int k = 0; k < num_sorted; k++)
+    pos[order[k]] = k;
+
+  for (int k = 0; k < num_sorted; k++) {
+    const NodeDesc &d = descs[order[k]];
+    Node &node = p.nodes[k];
+    strcpy(node.name, d.name);
+    node.type = d.type;
+    node.amount = d.amount;
+    if (d.source >= 0) {
+      node.object = sources[d.source].object;
+      node.gate = sources[d.source].gate;
+      node.param = sources[d.source].param;
+    }
+    else {
+      node.object = NULL;
+      node.gate = NULL;
+      node.param = d.amount_param ? d.amount_param : &node.amount;
+    }
+    node.out = d.type == kGraphInput ? input : p.blocks[k];
+    for (int j = 0; j < GRAPH_MAX_INPUTS; j++) {
+      int src = src_of[order[k]][j];
+      node.in[j] = src >= 0 ? p.nodes[pos[src]].out : silence;
+    }
+  }
+  p.num_nodes = num_sorted;
+  for (int c = 0; c < GRAPH_OUTPUTS; c++)
+    p.outputs[c] = output_src[c] >= 0 ? p.nodes[pos[output_src[c]]].out : silence;
+
+  __sync_synchronize();                 // Program complete before the swap is requested
+  swap_pending = true;
+  error = "";
+  return true;
+}
+
+/* === Audio i/o === */
+
+/**
+ * Swap in a newly committed program (at the block boundary), then render each node's
+ * block in sorted order.
+ */
+void AudioGraph::update() {
+
+  if (swap_pending) {
+    active ^= 1;
+    swap_pending = false;
+  }
+
+  Program &p = programs[active];
+  for (int n = 0; n < p.num_nodes; n++) {
+    Node &node = p.nodes[n];
+    const float *in0 = node.in[0];
+    const float *in1 = node.in[1];
+    float *out = node.out;
+
+    switch (node.type) {
+
+      case kGraphFollower: {
+        EnvelopeFollower *follower = (EnvelopeFollower *)node.object;
+        for (int i = 0; i < GRAPH_BLOCK_SAMPLES; i++)
+          out[i] = follower->process(in0[i]);
+        break;
+      }
+
+      case kGraphEnvelope: {
+        EnvelopeGenerator *egen = (EnvelopeGenerator *)node.object;
+        egen->renderBlock(out, GRAPH_BLOCK_SAMPLES, *node.gate ? in0 : NULL);
+        break;
+      }
+
+      case kGraphOscillator: {
+        Oscillator *osc = (Oscillator *)node.object;
+        osc->renderBlock(out, GRAPH_BLOCK_SAMPLES);
+        break;
+      }
+
+      case kGraphVoices: {
+        VoiceChannel *channel = (VoiceChannel *)node.object;
+        memcpy(out, in0, sizeof(float) * GRAPH_BLOCK_SAMPLES);
+        channel->mixVoices(out, GRAPH_BLOCK_SAMPLES);
+        break;
+      }
+
+      case kGraphDelay: {
+        CircularBuffer *buffer = (CircularBuffer *)node.object;
+        float delay = *node.param;
+        for (int i = 0; i < GRAPH_BLOCK_SAMPLES; i++) {
+          buffer->append(in0[i]);
+          out[i] = buffer->read(delay);
+        }
+        break;
+      }
+
+      case kGraphVca: {
+        float d = *node.param;
+        for (int i = 0; i < GRAPH_BLOCK_SAMPLES; i++)
+          out[i] = d * in1[i] * in0[i] + (1.0f - d) * in0[i];
+        break;
+      }
+
+      case kGraphMix: {
+        float m = *node.param;
+        for (int i = 0; i < GRAPH_BLOCK_SAMPLES; i++)
+          out[i] = m * in0[i] + (1.0f - m) * in1[i];
+        break;
+      }
+
+      case kGraphInput:
+      default:
+        break;
+    }
+  }
+}
+
+/* === Utility === */
+
+int AudioGraph::findSource(const char *name) {
+  for (int i = 0; i < num_sources; i++) {
+    if (strcmp(sources[i].name, name) == 0)
+      return i;
+  }
+  return -1;
+}
+
+int AudioGraph::findNode(const char *name) {
+  for (int i = 0; i < num_descs; i++) {
+    if (strcmp(descs[i].name, name) == 0)
+      return i;
+  }
+  return -1;
+}
+
+int AudioGraph::numInputs(GraphNodeType type) {
+  switch (type) {
+    case kGraphFollower:
+    case kGraphEnvelope:
+    case kGraphDelay:
+    case kGraphVoices:
+      return 1;
+    case kGraphVca:
+    case kGraphMix:
+      return 2;
+    default:
+      return 0;
+  }
+}
+
+bool AudioGraph::fail(const char *msg) {
+  error = msg;
+  return false;
+}
@@ -0,0 +1,137 @@
+/* AudioGraph.h
+ *
+ *  Block-processed audio graph, in the style of the Teensy Audio Library's update model.
+ *  Each node renders GRAPH_BLOCK_SAMPLES floats into its output block from the output
+ *  blocks of the nodes it reads.
+ *
+ *  The graph is patched at run time: nodes and connections are added to a pending
+ *  description by name, and commit() compiles it into a flat, topologically sorted array
+ *  of statically allocated nodes. update() dispatches on each node's type once per block,
+ *  so there is no virtual call per sample. Compiled programs are double buffered: commit()
+ *  fills the inactive program and update() swaps to it at the next block boundary.
+ *
+ *  Stateful nodes (follower, envelopes, oscillators, voice pools, delay) wrap the existing DSP objects,
+ *  registered as named sources, so parameters set over OSC apply in either engine and
+ *  their state carries across a swap. Each source may appear in a graph once. VCA and mix
+ *  nodes are stateless and can be instanced freely; their amount is either a constant
+ *  or bound to a parameter. Parameters are read once per block.
+ */
+
+#ifndef AUDIOGRAPH_H
+#define AUDIOGRAPH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "EnvelopeFollower.h"
+#include "EnvelopeGenerator.h"
+#include "Oscillator.h"
+#include "CircularBuffer.h"
+#include "VoiceChannel.h"
+
+#define GRAPH_BLOCK_SAMPLES (64)
+#define GRAPH_MAX_NODES (20)
+#define GRAPH_MAX_SOURCES (10)
+#define GRAPH_MAX_INPUTS (2)
+#define GRAPH_OUTPUTS (2)         // DAC channels
+#define GRAPH_NAME_LEN (12)
+
+typedef enum GraphNodeType {
+  kGraphInput = 0,      // Audio input block
+  kGraphFollower,       // in: audio
+  kGraphEnvelope,       // in: gate CV (when the follower gate is enabled)
+  kGraphOscillator,
+  kGraphDelay,          // in: audio
+  kGraphVca,            // in: audio, modulator. out = amount * mod * in + (1 - amount) * in
+  kGraphMix,            // in: a, b. out = amount * a + (1 - amount) * b
+  kGraphVoices          // in: voice 0. out = all of the channel's voices, scaled
+} GraphNodeType;
+
+class AudioGraph {
+
+public:
+
+  AudioGraph();
+  ~AudioGraph();
+
+  // Sources (setup)
+  bool addFollower(const char *name, EnvelopeFollower *follower);
+  bool addEnvelope(const char *name, EnvelopeGenerator *egen, const bool *follower_gate);
+  bool addOscillator(const char *name, Oscillator *osc);
+  bool addDelay(const char *name, CircularBuffer *buffer, const float *delay_samples);
+  bool addVoices(const char *name, VoiceChannel *channel);
+
+  // Pending description (main loop). Type is "input", "vca", "mix" or a source name.
+  void clear();
+  bool addNode(const char *name, const char *type, float amount = 1.0f,
+               const float *amount_param = NULL);
+  bool connect(const char *src, const char *dst, int input);
+  bool setOutput(const char *name, int channel);
+  bool setAmount(const char *name, float amount);     // Also applies to the live graph
+  bool commit();                    // Compile and swap in at the next block boundary
+  const char *getError()  { return error; }
+
+  // Audio i/o (block interrupt). Fill input, update, then read the outputs.
+  void update();
+  const float *getOutput(int channel)  { return programs[active].outputs[channel]; }
+  float input[GRAPH_BLOCK_SAMPLES];
+
+private:
+
+  typedef struct Source {
+    char name[GRAPH_NAME_LEN];
+    GraphNodeType type;
+    void *object;
+    const bool *gate;             // Envelope follower gate enable
+    const float *param;           // Delay time in samples
+  } Source;
+
+  typedef struct NodeDesc {
+    char name[GRAPH_NAME_LEN];
+    GraphNodeType type;
+    int source;                   // Index of the source, or -1
+    char inputs[GRAPH_MAX_INPUTS][GRAPH_NAME_LEN];    // Names of connected nodes
+    float amount;
+    const float *amount_param;    // Bound amount (overrides amount) or NULL
+  } NodeDesc;
+
+  typedef struct Node {
+    char name[GRAPH_NAME_LEN];
+    GraphNodeType type;
+    void *object;
+    const bool *gate;
+    const float *param;           // Amount or delay time
+    float amount;                 // Constant amount (param points here if unbound)
+    const float *in[GRAPH_MAX_INPUTS];
+    float *out;
+  } Node;
+
+  typedef struct Program {
+    Node nodes[GRAPH_MAX_NODES];  // Topologically sorted
+    int num_nodes;
+    float blocks[GRAPH_MAX_NODES][GRAPH_BLOCK_SAMPLES];
+    const float *outputs[GRAPH_OUTPUTS];
+  } Program;
+
+  bool addSource(const char *name, GraphNodeType type, void *object, const bool *gate,
+                 const float *param);
+  int findSource(const char *name);
+  int findNode(const char *name);
+  int numInputs(GraphNodeType type);
+  bool fail(const char *msg);
+
+  Source sources[GRAPH_MAX_SOURCES];
+  int num_sources;
+
+  NodeDesc descs[GRAPH_MAX_NODES];
+  int num_descs;
+  char outputs[GRAPH_OUTPUTS][GRAPH_NAME_LEN];
+
+  Program programs[2];
+  volatile int active;            // Program run by update()
+  volatile bool swap_pending;
+  const char *error;
+
+  static const float silence[GRAPH_BLOCK_SAMPLES];
+};
+
+#endif
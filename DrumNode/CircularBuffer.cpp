@@ -1,4 +1,5 @@
 #include "CircularBuffer.h"
+#pragma GCC diagnostic error "-Wdouble-promotion"
 
 CircularBuffer::CircularBuffer() : write_idx(0) {
   for (int i = 0; i < BUFFER_SIZE; i++)
@@ -22,8 +23,8 @@ float CircularBuffer::read(int16_t s_delay) {
 }
 
 float CircularBuffer::read(float s_delay) {
-  int16_t idx_0 = floor(s_delay);
-  int16_t idx_1 = ceil(s_delay);
+  int16_t idx_0 = floorf(s_delay);
+  int16_t idx_1 = ceilf(s_delay);
   float del = s_delay - idx_0;
   return ((1-del)*read(idx_0) + del*read(idx_1));
 }
@@ -0,0 +1,99 @@
+#include "ControlVoltageScanner.h"
+#include <math.h>
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+ControlVoltageScanner::ControlVoltageScanner(ADC *adc, int adc_max) :
+  adc(adc), adc_scale(1.0f / adc_max), num_channels(0), current(0), converting(false),
+  decimation(CV_DEFAULT_DECIMATION), smoothing(CV_DEFAULT_SMOOTHING),
+  threshold(CV_DEFAULT_THRESHOLD) { }
+
+ControlVoltageScanner::~ControlVoltageScanner() { }
+
+/**
+ * Add a CV pin to the scan. The pin must be readable by ADC1. Call before begin().
+ */
+int ControlVoltageScanner::addChannel(int pin, bool invert) {
+  if (num_channels == CV_MAX_CHANNELS)
+    return -1;
+  int ch = num_channels++;
+  pins[ch] = pin;
+  inverted[ch] = invert;
+  accumulator[ch] = 0;
+  count[ch] = 0;
+  smoothed[ch] = -1.0f;     // Seeded by the first decimated value
+  reported[ch] = 0.0f;
+  updated[ch] = false;
+  return ch;
+}
+
+void ControlVoltageScanner::begin() {
+  if (num_channels == 0)
+    return;
+  current = 0;
+  converting = adc->startSingleRead(pins[current], ADC_1);
+}
+
+void ControlVoltageScanner::setDecimation(int samples) {
+  decimation = samples > 0 ? samples : 1;
+}
+
+void ControlVoltageScanner::setSmoothing(float coef) {
+  smoothing = coef;
+}
+
+void ControlVoltageScanner::setThreshold(float thresh) {
+  threshold = thresh;
+}
+
+/**
+ * Called once per audio sample. A conversion takes far less than one audio period, so
+ * the one started on the previous call has always finished; if not, try again next time.
+ */
+void ControlVoltageScanner::scan() {
+
+  if (num_channels == 0)
+    return;
+
+  if (converting) {
+    if (!adc->isComplete(ADC_1))
+      return;
+    accumulator[current] += (uint16_t)adc->readSingle(ADC_1);
+    if (++count[current] == decimation) {
+      update(current, accumulator[current] * adc_scale / decimation);
+      accumulator[current] = 0;
+      count[current] = 0;
+    }
+    if (++current == num_channels)
+      current = 0;
+  }
+  converting = adc->startSingleRead(pins[current], ADC_1);
+}
+
+/**
+ * Smooth a decimated value and report it if it moved past the threshold.
+ */
+void ControlVoltageScanner::update(int ch, float value) {
+
+  if (inverted[ch])
+    value = 1.0f - value;
+
+  if (smoothed[ch] < 0.0f) {
+    smoothed[ch] = value;
+    reported[ch] = value;
+    updated[ch] = true;
+    return;
+  }
+
+  smoothed[ch] += smoothing * (value - smoothed[ch]);
+  if (fabsf(smoothed[ch] - reported[ch]) > threshold) {
+    reported[ch] = smoothed[ch];
+    updated[ch] = true;
+  }
+}
+
+bool ControlVoltageScanner::changed(int ch) {
+  if (!updated[ch])
+    return false;
+  updated[ch] = false;
+  return true;
+}
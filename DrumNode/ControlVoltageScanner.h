@@ -0,0 +1,68 @@
+/* ControlVoltageScanner.h
+ *
+ *  Background scan of the onboard CV pots on the second ADC module (ADC1), leaving ADC0
+ *  to the audio input. Each call to scan() (from the audio interrupt) collects the
+ *  conversion started on the previous call and starts the next channel, so conversions
+ *  never block. Raw samples are decimated (boxcar averaged), smoothed with a one-pole
+ *  filter, and only reported as changed when they move by more than a threshold.
+ */
+
+#ifndef CONTROLVOLTAGESCANNER_H
+#define CONTROLVOLTAGESCANNER_H
+
+#include <stdint.h>
+#include <ADC.h>
+
+#define CV_MAX_CHANNELS (4)
+#define CV_DEFAULT_DECIMATION (32)      // Raw samples averaged per channel update
+#define CV_DEFAULT_SMOOTHING (0.25f)    // One-pole coefficient at the decimated rate
+#define CV_DEFAULT_THRESHOLD (0.004f)   // Minimum reported change (~4 LSB at 10 bits)
+
+class ControlVoltageScanner {
+
+public:
+
+  ControlVoltageScanner(ADC *adc, int adc_max);
+  ~ControlVoltageScanner();
+
+  // Setup
+  int addChannel(int pin, bool invert);   // Returns the channel index
+  void begin();                           // Start the first conversion
+
+  // Parameter i/o
+  void setDecimation(int samples);
+  void setSmoothing(float coef);
+  void setThreshold(float thresh);
+
+  // Audio interrupt: collect the finished conversion and start the next one
+  void scan();
+
+  // Control i/o
+  bool changed(int ch);           // True once each time the value moves past the threshold
+  float getValue(int ch)  { return reported[ch]; }   // [0.0, 1.0]
+
+private:
+
+  void update(int ch, float value);
+
+  ADC *adc;
+  float adc_scale;                // 1 / adc_max
+
+  int num_channels;
+  int pins[CV_MAX_CHANNELS];
+  bool inverted[CV_MAX_CHANNELS];
+  int current;                    // Channel with a conversion in flight
+  bool converting;
+
+  int decimation;
+  float smoothing;
+  float threshold;
+
+  uint32_t accumulator[CV_MAX_CHANNELS];    // Raw sample sums for decimation
+  int count[CV_MAX_CHANNELS];
+  float smoothed[CV_MAX_CHANNELS];
+  volatile float reported[CV_MAX_CHANNELS];
+  volatile bool updated[CV_MAX_CHANNELS];
+};
+
+#endif
@@ -0,0 +1,49 @@
+#include "CpuLoadMeter.h"
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+CpuLoadMeter::CpuLoadMeter(const char *name) :
+  name(name), window_cycles(F_CPU * CPU_LOAD_WINDOW_S), window_start(0), busy_cycles(0),
+  runs(0), avg_cycles(0), peak_cycles(0), load(0.0f), max_load(0.0f), reset_pending(false) { }
+
+CpuLoadMeter::~CpuLoadMeter() { }
+
+void CpuLoadMeter::begin() {
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+}
+
+void CpuLoadMeter::stop(uint32_t start_cycles) {
+
+  uint32_t now = ARM_DWT_CYCCNT;
+  uint32_t cycles = now - start_cycles;
+
+  if (reset_pending) {
+    reset_pending = false;
+    peak_cycles = 0;
+    max_load = 0.0f;
+    busy_cycles = 0;
+    runs = 0;
+    window_start = start_cycles;
+  }
+
+  busy_cycles += cycles;
+  runs++;
+  if (cycles > peak_cycles)
+    peak_cycles = cycles;
+
+  // Close the window
+  uint32_t elapsed = now - window_start;
+  if (elapsed >= window_cycles) {
+    load = busy_cycles / (float)elapsed;
+    if (load > max_load)
+      max_load = load;
+    avg_cycles = busy_cycles / runs;
+    busy_cycles = 0;
+    runs = 0;
+    window_start = now;
+  }
+}
+
+void CpuLoadMeter::reset() {
+  reset_pending = true;
+}
@@ -0,0 +1,52 @@
+/* CpuLoadMeter.h
+ *
+ *  Measures the fraction of CPU time spent in a piece of interrupt code, using the
+ *  Cortex-M4 DWT cycle counter. Wrap the code with start()/stop(); busy cycles are summed
+ *  over a measurement window and the load is the busy fraction of the window's elapsed
+ *  cycles. One meter per interrupt, since stop() is not re-entrant.
+ */
+
+#ifndef CPULOADMETER_H
+#define CPULOADMETER_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#define CPU_LOAD_WINDOW_S (0.1f)
+
+class CpuLoadMeter {
+
+public:
+
+  CpuLoadMeter(const char *name);
+  ~CpuLoadMeter();
+
+  static void begin();            // Enable the cycle counter
+
+  // Interrupt i/o
+  uint32_t start()  { return ARM_DWT_CYCCNT; }
+  void stop(uint32_t start_cycles);
+
+  // Control i/o
+  const char *getName()  { return name; }
+  float getLoad()  { return load; }               // Most recent window [0.0, 1.0]
+  float getMaxLoad()  { return max_load; }        // Largest window since reset
+  float getPeakUs()  { return peak_cycles * 1e6f / F_CPU; }   // Longest single run
+  uint32_t getAvgCycles()  { return avg_cycles; }  // Mean run in the most recent window
+  void reset();
+
+private:
+
+  const char *name;
+  uint32_t window_cycles;
+  uint32_t window_start;
+  uint32_t busy_cycles;
+  uint32_t runs;
+  volatile uint32_t avg_cycles;
+  volatile uint32_t peak_cycles;
+  volatile float load;
+  volatile float max_load;
+  volatile bool reset_pending;    // Reset from the main loop, applied in stop()
+};
+
+#endif
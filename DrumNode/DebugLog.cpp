@@ -0,0 +1,120 @@
+#include "DebugLog.h"
+#include <string.h>
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+DebugLog::DebugLog() : enqueue_pos(0), dequeue_pos(0), dropped(0), dropped_reported(0) {
+  for (uint32_t i = 0; i < LOG_ENTRIES; i++)
+    entries[i].sequence = i;
+}
+
+DebugLog::~DebugLog() { }
+
+/**
+ * Claim a slot with a compare-and-swap on the enqueue position (bounded MPMC queue with
+ * per-slot sequence numbers), so interrupts may log while the main loop is logging.
+ */
+bool DebugLog::log(const char *fmt, LogArg a0, LogArg a1, LogArg a2, LogArg a3, LogArg a4,
+                   LogArg a5) {
+
+  LogEntry *entry;
+  uint32_t pos = __atomic_load_n(&enqueue_pos, __ATOMIC_RELAXED);
+  for (;;) {
+    entry = &entries[pos & (LOG_ENTRIES-1)];
+    uint32_t seq = __atomic_load_n(&entry->sequence, __ATOMIC_ACQUIRE);
+    int32_t dif = (int32_t)(seq - pos);
+    if (dif == 0) {
+      if (__atomic_compare_exchange_n(&enqueue_pos, &pos, pos + 1, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        break;
+    }
+    else if (dif < 0) {
+      __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+      return false;
+    }
+    else
+      pos = __atomic_load_n(&enqueue_pos, __ATOMIC_RELAXED);
+  }
+
+  const LogArg *args[LOG_MAX_ARGS] = { &a0, &a1, &a2, &a3, &a4, &a5 };
+  entry->fmt = fmt;
+  entry->num_args = 0;
+  entry->text[0] = '\0';
+  for (int i = 0; i < LOG_MAX_ARGS && args[i]->type; i++) {
+    entry->types[i] = args[i]->type;
+    if (args[i]->type == 's') {
+      strncpy(entry->text, args[i]->s ? args[i]->s : "", LOG_TEXT_LEN - 1);
+      entry->text[LOG_TEXT_LEN - 1] = '\0';
+    }
+    else if (args[i]->type == 'f')
+      entry->args[i].f = args[i]->f;
+    else
+      entry->args[i].i = args[i]->i;
+    entry->num_args++;
+  }
+
+  __atomic_store_n(&entry->sequence, pos + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+int DebugLog::drain(Print &out, int max_entries) {
+
+  uint32_t n_dropped = dropped;
+  if (n_dropped != dropped_reported) {
+    out.print("(");
+    out.print((unsigned long)(n_dropped - dropped_reported));
+    out.println(" log entries dropped)");
+    dropped_reported = n_dropped;
+  }
+
+  int n = 0;
+  while (n < max_entries) {
+    uint32_t pos = dequeue_pos;
+    LogEntry &entry = entries[pos & (LOG_ENTRIES-1)];
+    if (__atomic_load_n(&entry.sequence, __ATOMIC_ACQUIRE) != pos + 1)
+      break;          // Empty (or the next entry is still being written)
+    print(out, entry);
+    dequeue_pos = pos + 1;
+    __atomic_store_n(&entry.sequence, pos + LOG_ENTRIES, __ATOMIC_RELEASE);
+    n++;
+  }
+  return n;
+}
+
+bool DebugLog::available() {
+  uint32_t pos = dequeue_pos;
+  return __atomic_load_n(&entries[pos & (LOG_ENTRIES-1)].sequence, __ATOMIC_ACQUIRE) == pos + 1 ||
+         dropped != dropped_reported;
+}
+
+/**
+ * Print the format string, substituting stored arguments in order.
+ */
+void DebugLog::print(Print &out, const LogEntry &entry) {
+  int arg = 0;
+  for (const char *c = entry.fmt; *c; c++) {
+    if (*c != '%' || c[1] == '\0') {
+      out.write(*c);
+      continue;
+    }
+    c++;
+    if (*c == '%') {
+      out.write('%');
+      continue;
+    }
+    if (arg == entry.num_args)
+      continue;
+    switch (entry.types[arg]) {
+      case 'f':
+        out.print((double)entry.args[arg].f);
+        break;
+      case 's':
+        out.print(entry.text);
+        break;
+      default:
+        out.print(entry.args[arg].i);
+        break;
+    }
+    arg++;
+  }
+  out.println();
+}
@@ -0,0 +1,79 @@
+/* DebugLog.h
+ *
+ *  Lock-free binary debug log. Any context (including interrupts) can log a format string
+ *  and up to six int/float arguments; entries are stored unformatted in a fixed ring and
+ *  only formatted and printed when the main loop calls drain() at idle time.
+ *
+ *  Format strings must be string literals (only the pointer is stored). Supported
+ *  conversions are %d, %f and %s; a %s argument is copied (truncated to LOG_TEXT_LEN - 1
+ *  characters), and only one is allowed per entry.
+ */
+
+#ifndef DEBUGLOG_H
+#define DEBUGLOG_H
+
+#include <stdint.h>
+#include <Print.h>
+
+#define LOG_ENTRIES (64)        // Must be power of 2
+#define LOG_MAX_ARGS (6)
+#define LOG_TEXT_LEN (32)
+
+typedef struct LogArg {
+  char type;                    // 'd', 'f', 's', or 0 for no argument
+  union {
+    int32_t i;
+    float f;
+    const char *s;
+  };
+  LogArg() : type(0), i(0) { }
+  LogArg(int value) : type('d'), i(value) { }
+  LogArg(unsigned int value) : type('d'), i(value) { }
+  LogArg(long value) : type('d'), i(value) { }
+  LogArg(unsigned long value) : type('d'), i(value) { }
+  LogArg(float value) : type('f'), f(value) { }
+  LogArg(double value) : type('f'), f((float)value) { }
+  LogArg(const char *value) : type('s'), s(value) { }
+} LogArg;
+
+class DebugLog {
+
+public:
+
+  DebugLog();
+  ~DebugLog();
+
+  // Producers (any context). Returns false and counts a drop if the ring is full.
+  bool log(const char *fmt, LogArg a0 = LogArg(), LogArg a1 = LogArg(), LogArg a2 = LogArg(),
+           LogArg a3 = LogArg(), LogArg a4 = LogArg(), LogArg a5 = LogArg());
+
+  // Consumer (main loop, idle time). Formats and prints up to max_entries entries.
+  int drain(Print &out, int max_entries);
+  bool available();
+
+private:
+
+  typedef struct LogEntry {
+    volatile uint32_t sequence;   // Slot state for the lock-free queue
+    const char *fmt;
+    uint8_t num_args;
+    char types[LOG_MAX_ARGS];
+    union {
+      int32_t i;
+      float f;
+    } args[LOG_MAX_ARGS];
+    char text[LOG_TEXT_LEN];
+  } LogEntry;
+
+  void print(Print &out, const LogEntry &entry);
+
+  LogEntry entries[LOG_ENTRIES];
+  volatile uint32_t enqueue_pos;
+  volatile uint32_t dequeue_pos;
+  volatile uint32_t dropped;
+  uint32_t dropped_reported;
+};
+
+extern DebugLog debug_log;    // Defined in DrumNode.ino
+
+#endif
@@ -32,11 +32,29 @@
 // OSCMessage and SLIPEncodedSerial availab at https://github.com/sandeepmistry/esp8266-OSC
 
 #include <ADC.h>
+
+// The Cortex-M4F FPU is single precision only: promoting a float to double (a double
+// literal, libm call or double parameter) falls back to software. Make it a build error
+// in this file and the DrumNode headers below; the .cpp files do the same.
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
 #include "EnvelopeFollower.h"
 #include "EnvelopeGenerator.h"
 #include "Oscillator.h"
 #include "CircularBuffer.h"
 #include "NodeListenerArray.h"
+#include "ControlVoltageScanner.h"
+#include "LedRenderer.h"
+#include "OscPacketQueue.h"
+#include "DebugLog.h"
+#include "TaskScheduler.h"
+#include "VoiceChannel.h"
+#include "AudioGraph.h"
+#include "CpuLoadMeter.h"
+#include "ModMatrix.h"
+#include "FastMath.h"
+#include "WaveTableUpload.h"
+#include "Telemetry.h"
 
 #define PHASE_INVERT
 //#define CV1_INVERT
@@ -45,13 +63,15 @@
 #define BAUD_RATE_DEBUG (230400)
 #define BAUD_RATE_ESP (230400)
 //#define DEBUG_PRINT
+//#define AUDIO_GRAPH_ENGINE      // 44.1 kHz block graph (else 8 kHz per-sample ISR)
 
 /* Pin assignments */
 const int ADC_AUDIO = A0;           // Audio input
-const int ADC_CV1 = A17;
+const int ADC_CV1 = A17;            // CVs (all read by ADC1)
 const int ADC_CV2 = A18;
 const int ADC_CV3 = A3;
-const int DAC = A21;                // Audio Output
+const int DAC = A21;                // Audio Output (CH1)
+const int DAC_CH2 = A22;            // " " (CH2)
 const int LED_OSC = 13;
 const int LED_FOLLOWER = 3;
 const int LED_LFO = 4;
@@ -73,22 +93,32 @@ const int adc_scale = dac_res - adc_res;  // DAC res > ADC res
 /* Audio sampling */
 ADC *adc = new ADC();
 IntervalTimer audio_sample_timer;
+#ifdef AUDIO_GRAPH_ENGINE
+const float fs = 44100.0;              // Audio sample rate
+#else
 const float fs = 8000.0;               // Audio sample rate
-const float ts_us = 1 / fs * 1e6;       // " " period (microseconds)
+#endif
+const float ts_us = 1 / fs * 1e6f;       // " " period (microseconds)
 
 /* Audio rate objects */
 EnvelopeFollower follower = EnvelopeFollower(fs, 100.0, 100.0); // Env. Follower
-EnvelopeGenerator egen = EnvelopeGenerator(fs, 100.0, 1.0, 100.0);
-Oscillator lfo = Oscillator(fs, 2.0);
-Oscillator vco = Oscillator(fs, 60.0);
+Oscillator lfo = Oscillator(fs, 2.0, kInterpNone);  // Truncating: cheapest
+VoiceChannel ch1 = VoiceChannel(fs);   // Voice chains (VCO, EGEN, VCAs) for each DAC
+VoiceChannel ch2 = VoiceChannel(fs);
+VoiceChannel *osc_ch = &ch1;          // Channel selected by the current OSC message
 CircularBuffer delayBuffer = CircularBuffer();
+WaveTableUpload wave_upload = WaveTableUpload();   // User wave table (shared by all oscillators)
 
 // ADC/DAC ints
 int32_t adc_sample;       // Audio input
-int16_t dac_sample;       // Audio output
-int16_t adc_cv1;          // CVs from onboard pots
-int16_t adc_cv2;          // "
-int16_t adc_cv3;          // "
+int16_t dac_sample;       // Audio output (CH1)
+int16_t dac2_sample;      // " " (CH2)
+
+// CVs from onboard pots, scanned on ADC1 from the audio interrupt
+ControlVoltageScanner cv_scanner = ControlVoltageScanner(adc, adc_max);
+int cv1_ch;
+int cv2_ch;
+int cv3_ch;
 bool cv1_enable = true;
 bool cv2_enable = true;
 bool cv3_enable = true;
@@ -97,13 +127,13 @@ bool cv3_enable = true;
 float aud_sample;           // Audio input
 float vco_sample;           // Audio rate oscillator
 float out_sample;           // Audio input/oscillator mix
+float out2_sample;          // CH2 voice
 float follower_sample;      // Envelope follower
 float egen_sample;          // Envelope generator
 float lfo_sample;           // LFO (amplitude modulator)
 float sample_delay = 10.0;  // Sample delay 
 
 // Misc. effect parameters (note encapsulated in a synth class)
-bool follower_gate_enabled = true;  // Whether the EGEN can be triggered by the input follower
 bool kill_received = false;     // Temporarily stop propagation without disabling entirely
 bool propagate_enabled = false; // Enables starting/continuing propagation on EGEN falling edge
 bool propagating = false;       // Whether we're starting or continuing propagation on falling edge
@@ -112,12 +142,55 @@ float propagate_sus_level;      // Sustain level received by propagate message
 float previous_sus_level;       // Allows resetting EGEN sustain level after propgation message passes
 float propagate_decay = 0.25;   // Slope of sustain level between propgation messages
 
-float synth_vca_lfo_mod = 0.0;      // Modulation depth [0.0, 1.0]
 float fb_gain = 1.0;                // Audio input signal gain
 float fb_vca_lfo_mod = 0.0;         // Modulation depth [0.0, 1.0]
 float fb_vca_env_mod = 1.0;         // Modulation depth [0.0, 1.0]
 float fb_mix = 0.0;                 // Audio input/oscillator mix [0.0, 1.0]
 
+// Glide and the modulation matrix are updated once per control block in the audio interrupt
+#ifdef AUDIO_GRAPH_ENGINE
+const int control_block_samples = GRAPH_BLOCK_SAMPLES;
+#else
+const int control_block_samples = 16;
+#endif
+int control_count = 0;
+ModMatrix mod_matrix;
+float out_gain[2] = { 1.0, 1.0 };   // Modulated output gains (CH1, CH2)
+float fb_gain_mod = 0.0;            // Modulation offset of the audio input gain
+float fb_delay = 10.0;              // Modulated sample delay
+float gate_on_thresh = 0.5;         // Follower gate thresholds (set by CV3)
+float gate_off_thresh = 0.3;
+
+#ifdef AUDIO_GRAPH_ENGINE
+/* Audio graph, patched over OSC (/graph/...). Blocks are double buffered: the sample 
+ * interrupt plays and records one pair of blocks while the software interrupt renders the 
+ * other, so the output lags the input by two blocks (2.9 ms at 44.1 kHz). */
+AudioGraph graph;
+
+volatile int16_t adc_blocks[2][GRAPH_BLOCK_SAMPLES];       // Recorded by the sample interrupt
+volatile int16_t dac_blocks[2][2][GRAPH_BLOCK_SAMPLES];    // [block][channel][sample]
+volatile int io_block = 0;        // Block pair in use by the sample interrupt
+int io_idx = 0;
+volatile bool graph_busy = false;
+volatile uint32_t graph_overruns = 0;   // Blocks not rendered before they were needed
+
+/* Control rate objects (ticked once per block) */
+LedRenderer leds = LedRenderer(fs / GRAPH_BLOCK_SAMPLES, LED_DEFAULT_RATE_HZ);
+
+/* CPU load */
+CpuLoadMeter io_load("block_io");
+CpuLoadMeter graph_load("block_graph");
+CpuLoadMeter *load_meters[] = { &io_load, &graph_load };
+#else
+/* Control rate objects */
+LedRenderer leds = LedRenderer(fs, LED_DEFAULT_RATE_HZ);
+
+/* CPU load */
+CpuLoadMeter audio_load("sample_isr");
+CpuLoadMeter *load_meters[] = { &audio_load };
+#endif
+const int num_load_meters = sizeof(load_meters) / sizeof(load_meters[0]);
+
 /* OSC */
 IPAddress ip_local;
 IPAddress ip_multi;
@@ -126,16 +199,39 @@ IPAddress gate_remote_ip;
 int port_local;
 int port_multi;
 NodeListenerArray listener_array = NodeListenerArray();
+IPAddress heartbeat_ip;                   // Controller receiving envelope state heartbeats
+int heartbeat_port;
+unsigned long heartbeat_interval_ms = 0;  // Heartbeat disabled if zero
+Telemetry telemetry;                      // Message plane counters
+IPAddress telemetry_ip;                   // Collector receiving /telemetry
+int telemetry_port;
 
 OSCMessage incoming_msg;
 OSCMessage set_dest_out("/set_dest");
 OSCMessage propagate_out("/propagate");
+OSCMessage heartbeat_out("/heartbeat");
 
 /* Incoming OSC Handling (via SLIP Serial) */
 SLIPEncodedSerial SLIPSerial(Serial3);
 IntervalTimer osc_control_timer;
 const float fo = 16000.0;                // OSC sample rate
-const float to_us = 1 / fo * 1e6;       // " " period (microseconds)
+const float to_us = 1 / fo * 1e6f;       // " " period (microseconds)
+OscPacketQueue osc_queue;                // Packets received by the SLIP interrupt
+const int osc_packets_per_loop = 4;      // Max packets dispatched per loop() pass
+
+/* Debug logging (formatted and printed when loop() is idle) */
+DebugLog debug_log;
+const int log_entries_per_loop = 2;
+
+/* Main loop tasks, highest priority (lowest value) first */
+TaskScheduler scheduler;
+int falling_edge_task;
+int osc_task;
+int heartbeat_task;
+int telemetry_task;
+int cv_task;
+int led_task;
+int log_task;
 
 /* Setup */
 void setup() {
@@ -146,10 +242,30 @@ void setup() {
   pinMode(ADC_AUDIO, INPUT);            // Audio i/o
   analogWriteResolution(dac_res);
   pinMode(DAC, OUTPUT);
+  pinMode(DAC_CH2, OUTPUT);
+  ch2.follower_gate = false;            // CH2 is played by notes unless enabled over OSC
 
   pinMode(ADC_CV1, INPUT);              // CVs
   pinMode(ADC_CV2, INPUT);
   pinMode(ADC_CV3, INPUT);
+  adc->setResolution(adc_res, ADC_0);
+  adc->setResolution(adc_res, ADC_1);
+#ifdef CV1_INVERT
+  cv1_ch = cv_scanner.addChannel(ADC_CV1, true);
+#else
+  cv1_ch = cv_scanner.addChannel(ADC_CV1, false);
+#endif
+#ifdef CV2_INVERT
+  cv2_ch = cv_scanner.addChannel(ADC_CV2, true);
+#else
+  cv2_ch = cv_scanner.addChannel(ADC_CV2, false);
+#endif
+#ifdef CV3_INVERT
+  cv3_ch = cv_scanner.addChannel(ADC_CV3, true);
+#else
+  cv3_ch = cv_scanner.addChannel(ADC_CV3, false);
+#endif
+  cv_scanner.begin();
   
   pinMode(LED_OSC, OUTPUT);             // LEDs
   pinMode(LED_FOLLOWER, OUTPUT);
@@ -157,91 +273,282 @@ void setup() {
   pinMode(LED_R, OUTPUT);
   pinMode(LED_G, OUTPUT);
   pinMode(LED_B, OUTPUT);
+  leds.setPin(kLedFollower, LED_FOLLOWER);
+  leds.setPin(kLedLfo, LED_LFO);
+  leds.setPin(kLedEgen, LED_EGEN);
+  leds.setPin(kLedRed, LED_R);
+  leds.setPin(kLedGreen, LED_G);
+  leds.setPin(kLedBlue, LED_B);
 
   pinMode(MUTE_CH1, OUTPUT);            // Control output
   digitalWrite(MUTE_CH1, LOW);
 
+  ch1.setControlBlock(control_block_samples);
+  ch2.setControlBlock(control_block_samples);
+  mod_matrix.setDestination(kModDstVco1Pitch, mod_apply_vco1_pitch);
+  mod_matrix.setDestination(kModDstVco2Pitch, mod_apply_vco2_pitch);
+  mod_matrix.setDestination(kModDstLfoPitch, mod_apply_lfo_pitch);
+  mod_matrix.setDestination(kModDstVca1Gain, mod_apply_vca1_gain);
+  mod_matrix.setDestination(kModDstVca2Gain, mod_apply_vca2_gain);
+  mod_matrix.setDestination(kModDstFbGain, mod_apply_fb_gain);
+  mod_matrix.setDestination(kModDstDelay, mod_apply_delay);
+  mod_matrix.setDestination(kModDstGateThresh, mod_apply_gate_thresh);
+
+  CpuLoadMeter::begin();
+  for (int i = 0; i < num_load_meters; i++)
+    load_meters[i]->reset();
+
   // Start audio and OSC interval timers
+#ifdef AUDIO_GRAPH_ENGINE
+  audio_graph_init();
+  audio_sample_timer.begin(audio_io_interrupt, ts_us);
+#else
   audio_sample_timer.begin(audio_sample_interrupt, ts_us);
+#endif
   osc_control_timer.begin(handle_slip_osc, to_us);
+
+  // Propagation and outgoing messages run ahead of controls and cosmetic work
+  falling_edge_task = scheduler.addEvent("falling_edge", falling_edge, falling_edge_ready, 0, 1000);
+  osc_task = scheduler.addEvent("osc", handle_osc_queue, osc_ready, 1, 2000);
+  heartbeat_task = scheduler.addPeriodic("heartbeat", send_heartbeat, 50000, 2, 5000);
+  scheduler.setEnabled(heartbeat_task, false);
+  telemetry_task = scheduler.addPeriodic("telemetry", send_telemetry, 1000000, 2, 5000);
+  scheduler.setEnabled(telemetry_task, false);
+  cv_task = scheduler.addPeriodic("cv", process_cvs, 10000, 3, 10000);
+  led_task = scheduler.addPeriodic("leds", update_leds, 1e6f / LED_DEFAULT_RATE_HZ, 4, 10000);
+  log_task = scheduler.addEvent("log", drain_log, log_ready, 5, 100000);
 }
 
 /* -------------------------------------- */
 /* === Main Audio Processing Callback === */
 /* -------------------------------------- */
+#ifndef AUDIO_GRAPH_ENGINE
 void audio_sample_interrupt() {
 
+  uint32_t load_start = audio_load.start();
+
+  /* === Glide and modulation (once per control block) === */
+  if (++control_count == control_block_samples) {
+    control_count = 0;
+    update_control_block();
+  }
+
   /* === Audio feedback === */
   // Audio input
-  adc_sample = adc->analogRead(ADC_AUDIO);  // [0, adc_max]
+  adc_sample = adc->analogRead(ADC_AUDIO, ADC_0);  // [0, adc_max]
 #ifdef PHASE_INVERT
   adc_sample = adc_max - adc_sample;
 #endif
   adc_sample -= adc_half;                     // [-adc_half, adc_half]
   aud_sample = adc_sample / (float)adc_half;  // [-1.0, 1.0]
-  aud_sample *= fb_gain;
+  aud_sample *= fb_gain + fb_gain_mod;
 
-  // Envelope follower/generator
+  // Envelope follower gates
   follower_sample = follower.process(aud_sample);   // [0.0, 1.0]
-  if (follower_gate_enabled) egen.gate_cv(follower_sample);
-  egen_sample = egen.render();
+  if (ch1.follower_gate) ch1.egen.gate_cv(follower_sample);
+  if (ch2.follower_gate) ch2.egen.gate_cv(follower_sample);
+
+  /* === Synthesis === */
+  // Voice chains (oscillator, EGEN VCA, LFO VCA)
+  lfo_sample = lfo.render();              // [-1.0, 1.0]
+  vco_sample = ch1.render(lfo_sample);    // [-1.0, 1.0]
+  out2_sample = ch2.render(lfo_sample);
+  egen_sample = ch1.env_sample;
 
   // Audio sample delay
   delayBuffer.append(aud_sample);                 // Append current output sample
-  aud_sample = delayBuffer.read(sample_delay);    // Read delayed sample
+  aud_sample = delayBuffer.read(fb_delay);        // Read delayed sample
 
   // LFO amplitude modulation
-  lfo_sample = lfo.render();              // [-1.0, 1.0]
-  aud_sample = fb_vca_lfo_mod * lfo_sample * aud_sample + (1.0 - fb_vca_lfo_mod) * aud_sample;
+  aud_sample = fb_vca_lfo_mod * lfo_sample * aud_sample + (1.0f - fb_vca_lfo_mod) * aud_sample;
 
   // EGEN modulation
-  aud_sample = fb_vca_env_mod * egen_sample * aud_sample + (1.0 - fb_vca_env_mod) * aud_sample;
+  aud_sample = fb_vca_env_mod * egen_sample * aud_sample + (1.0f - fb_vca_env_mod) * aud_sample;
+
+  /* === Output === */
+  // CH1: Audio/Oscillator mix
+  out_sample = fb_mix * aud_sample + (1.0f - fb_mix) * vco_sample;  
+  dac_sample = dac_half * (out_gain[0] * out_sample + 1.0f);
+  analogWrite(DAC, dac_sample);
+  // CH2: Oscillator only
+  dac2_sample = dac_half * (out_gain[1] * out2_sample + 1.0f);
+  analogWrite(DAC_CH2, dac2_sample);
+
+  /* === Control === */
+  cv_scanner.scan();                      // Collect/start CV conversions on ADC1
+  leds.tick(follower_sample, lfo_sample, egen_sample, ch1.egen.was_cv_gated);
+
+  audio_load.stop(load_start);
+}
+#else
+/* ------------------------------- */
+/* === Block Audio Graph Engine === */
+/* ------------------------------- */
+void audio_graph_init() {
+  graph.addFollower("follower", &follower);
+  graph.addEnvelope("egen1", &ch1.egen, &ch1.follower_gate);
+  graph.addEnvelope("egen2", &ch2.egen, &ch2.follower_gate);
+  graph.addOscillator("lfo", &lfo);
+  graph.addOscillator("vco1", &ch1.vco);
+  graph.addOscillator("vco2", &ch2.vco);
+  graph.addDelay("delay", &delayBuffer, &fb_delay);
+  graph.addVoices("voices1", &ch1);
+  graph.addVoices("voices2", &ch2);
+  audio_graph_default();
+
+  for (int i = 0; i < GRAPH_BLOCK_SAMPLES; i++)
+    dac_blocks[0][0][i] = dac_blocks[0][1][i] = dac_blocks[1][0][i] = dac_blocks[1][1][i] = dac_half;
+
+  // Graph updates run in the software interrupt, below the sample and SLIP timers
+  attachInterruptVector(IRQ_SOFTWARE, audio_graph_update);
+  NVIC_SET_PRIORITY(IRQ_SOFTWARE, 208);
+  NVIC_ENABLE_IRQ(IRQ_SOFTWARE);
+}
 
-  /* === Synthesis === */
-  // Oscillator
-  vco_sample = vco.render();    // [-1.0, 1.0]
-  vco_sample *= egen_sample;
+/**
+ * The fixed per-sample chain as a graph, with VCA depths and the mix bound to the /fb, 
+ * /synth and /mixer parameters.
+ */
+void audio_graph_default() {
+  graph.clear();
+  graph.addNode("in", "input");
+  graph.addNode("follower", "follower");
+  graph.addNode("env1", "egen1");
+  graph.addNode("env2", "egen2");
+  graph.addNode("lfo", "lfo");
+  graph.addNode("delay", "delay");
+  graph.addNode("fb_lfo", "vca", 0.0, &fb_vca_lfo_mod);
+  graph.addNode("fb_env", "vca", 0.0, &fb_vca_env_mod);
+  graph.addNode("vco1", "vco1");
+  graph.addNode("vca1_env", "vca");
+  graph.addNode("poly1", "voices1");
+  graph.addNode("vca1_lfo", "vca", 0.0, &ch1.vca_lfo_mod);
+  graph.addNode("mix1", "mix", 0.0, &fb_mix);
+  graph.addNode("vco2", "vco2");
+  graph.addNode("vca2_env", "vca");
+  graph.addNode("poly2", "voices2");
+  graph.addNode("vca2_lfo", "vca", 0.0, &ch2.vca_lfo_mod);
+
+  graph.connect("in", "follower", 0);
+  graph.connect("follower", "env1", 0);
+  graph.connect("follower", "env2", 0);
+  graph.connect("in", "delay", 0);                // Feedback path
+  graph.connect("delay", "fb_lfo", 0);
+  graph.connect("lfo", "fb_lfo", 1);
+  graph.connect("fb_lfo", "fb_env", 0);
+  graph.connect("env1", "fb_env", 1);
+  graph.connect("vco1", "vca1_env", 0);           // CH1 voice
+  graph.connect("env1", "vca1_env", 1);
+  graph.connect("vca1_env", "poly1", 0);          // Voices 1 and up, when playing
+  graph.connect("poly1", "vca1_lfo", 0);
+  graph.connect("lfo", "vca1_lfo", 1);
+  graph.connect("fb_env", "mix1", 0);
+  graph.connect("vca1_lfo", "mix1", 1);
+  graph.connect("vco2", "vca2_env", 0);           // CH2 voice
+  graph.connect("env2", "vca2_env", 1);
+  graph.connect("vca2_env", "poly2", 0);
+  graph.connect("poly2", "vca2_lfo", 0);
+  graph.connect("lfo", "vca2_lfo", 1);
+
+  graph.setOutput("mix1", 0);
+  graph.setOutput("vca2_lfo", 1);
+  graph.commit();
+}
 
-  // LFO amplitude modulation
-  vco_sample = synth_vca_lfo_mod * lfo_sample * vco_sample + (1.0 - synth_vca_lfo_mod) * vco_sample;
+/**
+ * Sample interrupt: record the audio input and play both outputs from the current block 
+ * pair. At the end of a block, swap pairs and trigger the graph to render the next one.
+ */
+void audio_io_interrupt() {
+
+  uint32_t load_start = io_load.start();
+
+  adc_sample = adc->analogRead(ADC_AUDIO, ADC_0);   // [0, adc_max]
+  adc_blocks[io_block][io_idx] = adc_sample;
+  analogWrite(DAC, dac_blocks[io_block][0][io_idx]);
+  analogWrite(DAC_CH2, dac_blocks[io_block][1][io_idx]);
+  cv_scanner.scan();                      // Collect/start CV conversions on ADC1
+
+  if (++io_idx == GRAPH_BLOCK_SAMPLES) {
+    io_idx = 0;
+    io_block ^= 1;
+    if (graph_busy)
+      graph_overruns++;
+    else
+      NVIC_SET_PENDING(IRQ_SOFTWARE);
+  }
+
+  io_load.stop(load_start);
+}
 
-  // Audio/Oscillator mix
-  out_sample = fb_mix * aud_sample + (1.0 - fb_mix) * vco_sample;  
-  dac_sample = dac_half * (out_sample + 1.0);
-  analogWrite(DAC, dac_sample);           // Output
+/**
+ * Software interrupt: render one block through the graph from the block pair the sample
+ * interrupt just finished with.
+ */
+void audio_graph_update() {
+
+  uint32_t load_start = graph_load.start();
+  graph_busy = true;
+  int b = io_block ^ 1;
+
+  update_control_block();
+
+  // Audio input
+  for (int i = 0; i < GRAPH_BLOCK_SAMPLES; i++) {
+    int32_t x = adc_blocks[b][i];
+#ifdef PHASE_INVERT
+    x = adc_max - x;
+#endif
+    graph.input[i] = (x - adc_half) / (float)adc_half * (fb_gain + fb_gain_mod);
+  }
+
+  graph.update();
+
+  // Audio output
+  const float *out1 = graph.getOutput(0);
+  const float *out2 = graph.getOutput(1);
+  for (int i = 0; i < GRAPH_BLOCK_SAMPLES; i++) {
+    dac_blocks[b][0][i] = dac_half * (out_gain[0] * out1[i] + 1.0f);
+    dac_blocks[b][1][i] = dac_half * (out_gain[1] * out2[i] + 1.0f);
+  }
+
+  /* === Control === */
+  follower_sample = follower.getValue();
+  lfo_sample = lfo.value;
+  egen_sample = ch1.egen.getLevel();
+  leds.tick(follower_sample, lfo_sample, egen_sample, ch1.egen.was_cv_gated);
+
+  graph_busy = false;
+  graph_load.stop(load_start);
 }
+#endif
 
 void loop() {
+  scheduler.run();    // Run the highest priority task that's due
+  telemetry.countLoop();
+}
 
-  // Look for falling edge on the envelope generator to trigger listeners
-  if (egen.falling_edge) 
-    falling_edge();
+/* === Task ready checks === */
+// Look for falling edge on the envelope generator to trigger listeners
+bool falling_edge_ready() { return ch1.egen.falling_edge; }
+// OSC messages received by the SLIP interrupt
+bool osc_ready() { return osc_queue.available(); }
+// Debug output (lowest priority, so only printed when nothing else is due)
+bool log_ready() { return debug_log.available(); }
 
+/* === Control and cosmetic tasks === */
+void process_cvs() {
 //  process_cv_1();
 //  process_cv_2();
   process_cv_3();
+}
 
-//  lfo.setF0Mod(egen_sample);      // EGEN-->LFO mod
-//  vco.setF0Mod(lfo_sample);       // LFO--->VCO mod
-
-  int s_f = 1023 * follower_sample;
-  int s_l = 512 * (lfo_sample + 1.0);
-  int s_g = egen_sample * 1023;
-
-  analogWrite(LED_FOLLOWER, s_f);
-  analogWrite(LED_LFO, s_l);
-  analogWrite(LED_EGEN, s_g);
+void update_leds() {
+  leds.update();      // Writes only channels that changed
+}
 
-  if (egen.was_cv_gated) {
-    analogWrite(LED_R, s_g);        // LED Bulb
-    analogWrite(LED_G, s_g);
-    analogWrite(LED_B, s_g);
-  }
-  else {
-    analogWrite(LED_R, s_g / (1.0-synth_vca_lfo_mod));        // LED Bulb
-    analogWrite(LED_G, s_g / 2.0 / (1.0-synth_vca_lfo_mod));
-    analogWrite(LED_B, s_g / 4.0);
-  }
+void drain_log() {
+  debug_log.drain(Serial, log_entries_per_loop);
 }
 
 /**
@@ -252,10 +559,10 @@ void loop() {
  */
 void falling_edge() {
 
-  egen.falling_edge = false;    // Reset flag indicating falling edge was handled
-  if (egen.was_cv_gated) {
+  ch1.egen.falling_edge = false;    // Reset flag indicating falling edge was handled
+  if (ch1.egen.was_cv_gated) {
     gate_remote_ip = IPAddress(0, 0, 0, 0);
-    egen.was_cv_gated = false;
+    ch1.egen.was_cv_gated = false;
     propagating = false;
   }
 
@@ -263,7 +570,7 @@ void falling_edge() {
   if (!propagate_enabled || kill_received) {
     kill_received = false;
     propagating = false;
-    egen.falling_edge = false;
+    ch1.egen.falling_edge = false;
     return;
   }
 
@@ -273,31 +580,32 @@ void falling_edge() {
   if (!propagating) 
     outgoing_prop_sus = 1.0;
   else {  // Set propagation message with current amplitude minus decay
-    outgoing_prop_sus = fmax(0.0, propagate_sus_level - propagate_decay); 
-    egen.setSustainLevel(previous_sus_level);   // Restore previous sustain level 
+    outgoing_prop_sus = fmaxf(0.0f, propagate_sus_level - propagate_decay); 
+    noInterrupts();
+    ch1.egen.setSustainLevel(previous_sus_level);   // Restore previous sustain level 
+    interrupts();
   }
 
   propagating = false;
 
   // Only propagate if the sustain level exceeds a threshold
-  if (outgoing_prop_sus > 0.05) {
+  if (outgoing_prop_sus > 0.05f) {
     propagate_out.set(0, outgoing_prop_sus);
     
     // Send propagation message back to the source
     if (propagate_reflect) {
-      Serial.println("propagate_reflect");
-      for (int j = 0; j < 4; j++) {
+      debug_log.log("propagate_reflect %d.%d.%d.%d [%d]", gate_remote_ip[0], gate_remote_ip[1],
+                    gate_remote_ip[2], gate_remote_ip[3], port_local);
+      for (int j = 0; j < 4; j++)
         set_dest_out.set(j, (int)gate_remote_ip[j]);
-        Serial.println((int)gate_remote_ip[j]);
-      }
       set_dest_out.set(4, port_local);
-      Serial.println(port_local);
       slip_send(set_dest_out);
       slip_send(propagate_out);
+      telemetry.prop_sent++;
     }
     // Send propagation message to any listeners, excluding the propagation source 
     else {  
-      Serial.println("!propagate_reflect");
+      debug_log.log("!propagate_reflect");
       for (int i = 0; i < listener_array.count(); i++) {
         if (listener_array[i].ip != gate_remote_ip) {
           for (int j = 0; j < 4; j++)
@@ -305,108 +613,247 @@ void falling_edge() {
           set_dest_out.set(4, listener_array[i].port);
           slip_send(set_dest_out);
           slip_send(propagate_out);
+          telemetry.prop_sent++;
         }
       } 
     }
   }
 }
 
+/**
+ * Send channel 1's busiest voice state and loudest voice level to the controller that
+ * requested heartbeats, so a node sounding any of its voices isn't taken for idle.
+ */
+void send_heartbeat() {
+  for (int j = 0; j < 4; j++)
+    set_dest_out.set(j, (int)heartbeat_ip[j]);
+  set_dest_out.set(4, heartbeat_port);
+  heartbeat_out.set(0, (int)ch1.getState());
+  heartbeat_out.set(1, ch1.getLevel());
+  slip_send(set_dest_out);
+  slip_send(heartbeat_out);
+}
+
+/**
+ * Send the message plane counters to the telemetry collector in one packet:
+ *   /telemetry "iiiiiiiiiiii[si]..." <loops_per_s><osc_received><osc_errors><slip_dropped>
+ *     <prop_sent><prop_received><esp_udp_received><esp_udp_errors><esp_slip_errors>
+ *     <esp_wifi_reconnects><esp_loops_per_s><other_addresses>[<address><count>]...
+ * Counts are totals since boot; loop rates are over the last period. SLIP packets are 
+ * dropped when the receive queue is full or a packet is too long.
+ */
+void send_telemetry() {
+  OSCMessage telemetry_out("/telemetry");
+  telemetry_out.add((int)telemetry.loopsPerSecond(millis()));
+  telemetry_out.add((int)telemetry.osc_received);
+  telemetry_out.add((int)telemetry.osc_errors);
+  telemetry_out.add((int)osc_queue.droppedCount());
+  telemetry_out.add((int)telemetry.prop_sent);
+  telemetry_out.add((int)telemetry.prop_received);
+  for (int i = 0; i < kEspNumFields; i++)
+    telemetry_out.add((int)telemetry.esp[i]);
+  telemetry_out.add((int)telemetry.other_addresses);
+  for (int i = 0; i < telemetry.numAddresses(); i++) {
+    telemetry_out.add(telemetry.getAddress(i));
+    telemetry_out.add((int)telemetry.getAddressCount(i));
+  }
+  for (int j = 0; j < 4; j++)
+    set_dest_out.set(j, (int)telemetry_ip[j]);
+  set_dest_out.set(4, telemetry_port);
+  slip_send(set_dest_out);
+  slip_send(telemetry_out);
+}
+
 /* === CV1 === */
 void process_cv_1() {
-  adc_cv1 = adc->analogRead(ADC_CV1);     // [0, adc_max]
-#ifdef CV1_INVERT
-  adc_cv1 = adc_max - adc_cv1;
-#endif
-  float new_val = adc_cv1 / (float)adc_max;       // [0, 1.0]
+  if (!cv1_enable || !cv_scanner.changed(cv1_ch))
+    return;
+  float new_val = cv_scanner.getValue(cv1_ch);    // [0, 1.0]
 }
 
 /* === CV2 === */
 void process_cv_2() {
-  adc_cv2 = adc->analogRead(ADC_CV2);
-#ifdef CV2_INVERT
-  adc_cv2 = adc_max - adc_cv2;
-#endif
-  float new_val = adc_cv2 / (float)adc_max;
+  if (!cv2_enable || !cv_scanner.changed(cv2_ch))
+    return;
+  float new_val = cv_scanner.getValue(cv2_ch);
 }
 
 /* === CV3: EGEN Follower Gate Threshold === */
 void process_cv_3() {
-  adc_cv3 = adc->analogRead(ADC_CV3);
-#ifdef CV3_INVERT
-  adc_cv3 = adc_max - adc_cv3;
-#endif
-  float new_val = adc_cv3 / (float)adc_max;
-  float on_thresh = new_val * 2.0;
-  float off_thresh = min(on_thresh - 0.5, 0.2);
-  egen.setGateOnThresh(on_thresh);
-  egen.setGateOffThresh(off_thresh);
+  if (!cv3_enable || !cv_scanner.changed(cv3_ch))   // Only when the pot moves
+    return;
+  float new_val = cv_scanner.getValue(cv3_ch);
+  float on_thresh = new_val * 2.0f;
+  float off_thresh = min(on_thresh - 0.5f, 0.2f);
+  gate_on_thresh = on_thresh;       // Applied with modulation at the next control block
+  gate_off_thresh = off_thresh;
+  mod_matrix.refresh(kModDstGateThresh);
+}
+
+/* === Control block === */
+// Swap in an uploaded wave table, advance glides, then read modulation sources and apply
+// the destinations whose modulation changed (audio interrupt)
+void update_control_block() {
+  if (wave_upload.update())
+    Oscillator::setUserTable(wave_upload.getTable());
+
+  ch1.updateGlide();
+  ch2.updateGlide();
+  ch1.updateGain();
+  ch2.updateGain();
+
+  mod_matrix.setSource(kModSrcLfo, lfo.value);
+  mod_matrix.setSource(kModSrcEgen1, ch1.egen.getLevel());
+  mod_matrix.setSource(kModSrcEgen2, ch2.egen.getLevel());
+  mod_matrix.setSource(kModSrcFollower, follower.getValue());
+  mod_matrix.setSource(kModSrcCv1, cv_scanner.getValue(cv1_ch));
+  mod_matrix.setSource(kModSrcCv2, cv_scanner.getValue(cv2_ch));
+  mod_matrix.setSource(kModSrcCv3, cv_scanner.getValue(cv3_ch));
+  mod_matrix.evaluate();
+}
+
+void mod_apply_vco1_pitch(float octaves) { ch1.setPitchMod(octaves); }
+void mod_apply_vco2_pitch(float octaves) { ch2.setPitchMod(octaves); }
+void mod_apply_lfo_pitch(float octaves) { lfo.setPitchMod(octaves); }
+void mod_apply_vca1_gain(float mod) { out_gain[0] = constrain(1.0f + mod, 0.0f, 1.0f); }
+void mod_apply_vca2_gain(float mod) { out_gain[1] = constrain(1.0f + mod, 0.0f, 1.0f); }
+void mod_apply_fb_gain(float mod) { fb_gain_mod = mod; }
+void mod_apply_delay(float mod) { fb_delay = constrain(sample_delay + mod, 0.0f, BUFFER_SIZE - 2.0f); }
+
+void mod_apply_gate_thresh(float mod) {
+  ch1.egen.setGateOnThresh(gate_on_thresh + mod);
+  ch1.egen.setGateOffThresh(gate_off_thresh + mod);
+  ch2.egen.setGateOnThresh(gate_on_thresh + mod);
+  ch2.egen.setGateOffThresh(gate_off_thresh + mod);
 }
 
 /* === SLIP Serial Handling === */
 void handle_slip_osc() {
 
-  // At the end of SLIP Serial packets, route OSC messages to their handlers
-  if (SLIPSerial.endofPacket()) {
+  // At the end of SLIP Serial packets, queue the packet for the main loop
+  if (SLIPSerial.endofPacket())
+    osc_queue.endPacket();
+  // Otherwise, copy SLIP-decoded bytes into the packet being received
+  else {
+    int n_bytes = SLIPSerial.available();
+    while (n_bytes--)
+      osc_queue.write(SLIPSerial.read());
+  }
+}
+
+/**
+ * Parse and dispatch a bounded number of queued OSC packets. Handlers run here in the 
+ * main context rather than in the SLIP interrupt, so the audio interrupt can preempt them;
+ * they change voice, envelope and oscillator state with interrupts disabled.
+ */
+void handle_osc_queue() {
+  int size;
+  for (int i = 0; i < osc_packets_per_loop && osc_queue.available(); i++) {
+    uint8_t *data = osc_queue.front(size);
+    incoming_msg.fill(data, size);
     if (!incoming_msg.hasError()) {
       digitalWrite(LED_OSC, HIGH);
       handle_osc(incoming_msg);       // Pass to main OSC message handler
     }
+    else
+      telemetry.osc_errors++;
     incoming_msg.empty();             // Clear OSC data
     incoming_msg.setAddress(NULL);    // Clear OSC path
+    osc_queue.pop();
   }
-  // Otherwise, populate an OSC message using SLIP serial bytes
-  else {
+  if (!osc_queue.available())
     digitalWrite(LED_OSC, LOW);
-    int n_bytes = SLIPSerial.available();
-    while (n_bytes--)
-      incoming_msg.fill(SLIPSerial.read());
-  }
 }
 
 void handle_osc(OSCMessage &msg) {
   char path[128];
   incoming_msg.getAddress(path);
+  telemetry.countMessage(path);
+  char *addr = select_channel(path);
 
 #ifdef DEBUG_PRINT
   handle_test(incoming_msg);
 #endif
 
   /* Messages that should originate from the ESP8266 */
-  if (strcmp(path, "/debug") == 0) handle_debug(incoming_msg);
-  else if (strcmp(path, "/set_port/local") == 0) handle_set_port_local(incoming_msg);
-  else if (strcmp(path, "/set_port/multi") == 0) handle_set_port_multi(incoming_msg);
-  else if (strcmp(path, "/remote_ip") == 0) handle_remote_ip(incoming_msg);
+  if (strcmp(addr, "/debug") == 0) handle_debug(incoming_msg);
+  else if (strcmp(addr, "/set_port/local") == 0) handle_set_port_local(incoming_msg);
+  else if (strcmp(addr, "/set_port/multi") == 0) handle_set_port_multi(incoming_msg);
+  else if (strcmp(addr, "/remote_ip") == 0) handle_remote_ip(incoming_msg);
+  else if (strcmp(addr, "/esp/telemetry") == 0) handle_esp_telemetry(incoming_msg);
   /* Messages that should originaate from the central controller */
-  else if (strcmp(path, "/add_listener") == 0) listener_array.handle_add_listener(incoming_msg);
-  else if (strcmp(path, "/remove_listener") == 0) listener_array.handle_remove_listener(incoming_msg);
-  else if (strcmp(path, "/remove_listeners") == 0) listener_array.handle_remove_listeners(incoming_msg);
+  else if (strcmp(addr, "/add_listener") == 0) listener_array.handle_add_listener(incoming_msg);
+  else if (strcmp(addr, "/remove_listener") == 0) listener_array.handle_remove_listener(incoming_msg);
+  else if (strcmp(addr, "/remove_listeners") == 0) listener_array.handle_remove_listeners(incoming_msg);
+  else if (strcmp(addr, "/heartbeat") == 0) handle_heartbeat(incoming_msg);
+  else if (strcmp(addr, "/telemetry") == 0) handle_telemetry(incoming_msg);
+  else if (strcmp(addr, "/stats/tasks") == 0) handle_stats_tasks(incoming_msg);
+  else if (strcmp(addr, "/stats/reset") == 0) handle_stats_reset(incoming_msg);
+  else if (strcmp(addr, "/stats/audio") == 0) handle_stats_audio(incoming_msg);
+  else if (strcmp(addr, "/stats/fastmath") == 0) handle_stats_fastmath(incoming_msg);
   /* Messages that may originate from the central controller or other modules */
-  else if (strcmp(path, "/test") == 0) handle_test(incoming_msg);
-  else if (strcmp(path, "/mute") == 0) handle_mute(incoming_msg);
-  else if (strcmp(path, "/note") == 0) handle_note(incoming_msg);
-  else if (strcmp(path, "/propagate") == 0) handle_propagate(incoming_msg);
-  else if (strcmp(path, "/propagate/decay") == 0) handle_propagate_decay(incoming_msg);
-  else if (strcmp(path, "/propagate/enable") == 0) handle_propagate_enable(incoming_msg);
-  else if (strcmp(path, "/propagate/kill") == 0) handle_propagate_kill(incoming_msg);
-  else if (strcmp(path, "/propagate/reflect") == 0) handle_propagate_reflect(incoming_msg);
-  else if (strcmp(path, "/mod/lfo/wave_shape") == 0) mod_handle_lfo_wave_shape(incoming_msg);
-  else if (strcmp(path, "/mod/lfo/rate") == 0) mod_handle_lfo_rate(incoming_msg);
-  else if (strcmp(path, "/mod/lfo/env_mod") == 0) mod_handle_lfo_env_mod(incoming_msg);
-  else if (strcmp(path, "/mod/egen/atk_time") == 0) mod_handle_egen_atk(incoming_msg);
-  else if (strcmp(path, "/mod/egen/sus_level") == 0) mod_handle_egen_sus(incoming_msg);
-  else if (strcmp(path, "/mod/egen/rel_time") == 0) mod_handle_egen_rel(incoming_msg);
-  else if (strcmp(path, "/mod/egen/do_sus") == 0) mod_handle_egen_do_sus(incoming_msg);
-  else if (strcmp(path, "/mod/egen/follower_gate") == 0) mod_handle_egen_follower_gate(incoming_msg);
-  else if (strcmp(path, "/mod/egen/gate") == 0) mod_handle_egen_gate(incoming_msg);
-  else if (strcmp(path, "/synth/vco/wave_shape") == 0) synth_handle_vco_wave_shape(incoming_msg);
-  else if (strcmp(path, "/synth/vco/freq") == 0) synth_handle_vco_freq(incoming_msg);
-  else if (strcmp(path, "/synth/vco/lfo_mod") == 0) synth_handle_vco_lfo_mod(incoming_msg);
-  else if (strcmp(path, "/synth/vca/lfo_mod") == 0) synth_handle_vca_lfo_mod(incoming_msg);
-  else if (strcmp(path, "/fb/gain") == 0) fb_handle_gain(incoming_msg);
-  else if (strcmp(path, "/fb/phase") == 0) fb_handle_phase(incoming_msg);
-  else if (strcmp(path, "/fb/vca/lfo_mod") == 0) fb_handle_vca_lfo_mod(incoming_msg);
-  else if (strcmp(path, "/fb/vca/env_mod") == 0) fb_handle_vca_env_mod(incoming_msg);
-  else if (strcmp(path, "/mixer/synth_feedback_mix") == 0) mixer_handle_synth_feedback_mix(incoming_msg);
+  else if (strcmp(addr, "/test") == 0) handle_test(incoming_msg);
+  else if (strcmp(addr, "/mute") == 0) handle_mute(incoming_msg);
+  else if (strcmp(addr, "/note") == 0) handle_note(incoming_msg);
+  else if (strcmp(addr, "/propagate") == 0) handle_propagate(incoming_msg);
+  else if (strcmp(addr, "/propagate/decay") == 0) handle_propagate_decay(incoming_msg);
+  else if (strcmp(addr, "/propagate/enable") == 0) handle_propagate_enable(incoming_msg);
+  else if (strcmp(addr, "/propagate/kill") == 0) handle_propagate_kill(incoming_msg);
+  else if (strcmp(addr, "/propagate/reflect") == 0) handle_propagate_reflect(incoming_msg);
+  else if (strcmp(addr, "/mod/lfo/wave_shape") == 0) mod_handle_lfo_wave_shape(incoming_msg);
+  else if (strcmp(addr, "/mod/lfo/rate") == 0) mod_handle_lfo_rate(incoming_msg);
+  else if (strcmp(addr, "/mod/lfo/env_mod") == 0) mod_handle_lfo_env_mod(incoming_msg);
+  else if (strcmp(addr, "/mod/matrix/route") == 0) mod_handle_matrix_route(incoming_msg);
+  else if (strcmp(addr, "/mod/matrix/clear") == 0) mod_handle_matrix_clear(incoming_msg);
+  else if (strcmp(addr, "/mod/egen/atk_time") == 0) mod_handle_egen_atk(incoming_msg);
+  else if (strcmp(addr, "/mod/egen/sus_level") == 0) mod_handle_egen_sus(incoming_msg);
+  else if (strcmp(addr, "/mod/egen/rel_time") == 0) mod_handle_egen_rel(incoming_msg);
+  else if (strcmp(addr, "/mod/egen/do_sus") == 0) mod_handle_egen_do_sus(incoming_msg);
+  else if (strcmp(addr, "/mod/egen/follower_gate") == 0) mod_handle_egen_follower_gate(incoming_msg);
+  else if (strcmp(addr, "/mod/egen/gate") == 0) mod_handle_egen_gate(incoming_msg);
+  else if (strcmp(addr, "/mod/egen/shape") == 0) mod_handle_egen_shape(incoming_msg);
+  else if (strcmp(addr, "/synth/vco/wave_shape") == 0) synth_handle_vco_wave_shape(incoming_msg);
+  else if (strcmp(addr, "/synth/vco/morph") == 0) synth_handle_vco_morph(incoming_msg);
+  else if (strcmp(addr, "/synth/vco/table") == 0) synth_handle_vco_table(incoming_msg);
+  else if (strcmp(addr, "/synth/poly") == 0) synth_handle_poly(incoming_msg);
+  else if (strcmp(addr, "/synth/vco/freq") == 0) synth_handle_vco_freq(incoming_msg);
+  else if (strcmp(addr, "/synth/vco/glide") == 0) synth_handle_vco_glide(incoming_msg);
+  else if (strcmp(addr, "/synth/vco/lfo_mod") == 0) synth_handle_vco_lfo_mod(incoming_msg);
+  else if (strcmp(addr, "/synth/vca/lfo_mod") == 0) synth_handle_vca_lfo_mod(incoming_msg);
+  else if (strcmp(addr, "/fb/gain") == 0) fb_handle_gain(incoming_msg);
+  else if (strcmp(addr, "/fb/phase") == 0) fb_handle_phase(incoming_msg);
+  else if (strcmp(addr, "/fb/vca/lfo_mod") == 0) fb_handle_vca_lfo_mod(incoming_msg);
+  else if (strcmp(addr, "/fb/vca/env_mod") == 0) fb_handle_vca_env_mod(incoming_msg);
+  else if (strcmp(addr, "/mixer/synth_feedback_mix") == 0) mixer_handle_synth_feedback_mix(incoming_msg);
+  else if (strcmp(addr, "/led/color/gated") == 0) led_handle_color_gated(incoming_msg);
+  else if (strcmp(addr, "/led/color/note") == 0) led_handle_color_note(incoming_msg);
+  else if (strcmp(addr, "/led/gamma") == 0) led_handle_gamma(incoming_msg);
+  else if (strcmp(addr, "/led/brightness") == 0) led_handle_brightness(incoming_msg);
+#ifdef AUDIO_GRAPH_ENGINE
+  else if (strcmp(addr, "/graph/clear") == 0) graph_handle_clear(incoming_msg);
+  else if (strcmp(addr, "/graph/node") == 0) graph_handle_node(incoming_msg);
+  else if (strcmp(addr, "/graph/connect") == 0) graph_handle_connect(incoming_msg);
+  else if (strcmp(addr, "/graph/output") == 0) graph_handle_output(incoming_msg);
+  else if (strcmp(addr, "/graph/amount") == 0) graph_handle_amount(incoming_msg);
+  else if (strcmp(addr, "/graph/commit") == 0) graph_handle_commit(incoming_msg);
+  else if (strcmp(addr, "/graph/default") == 0) graph_handle_default(incoming_msg);
+#endif
+}
+
+/**
+ * Channel namespaces: /ch1/<path> and /ch2/<path> select the voice chain that note, 
+ * /mod/egen/* and /synth/* messages apply to. Un-prefixed messages select channel 1. 
+ * Returns the path with the channel prefix removed.
+ */
+char *select_channel(char *path) {
+  osc_ch = &ch1;
+  if (strncmp(path, "/ch2/", 5) == 0) {
+    osc_ch = &ch2;
+    return path + 4;
+  }
+  if (strncmp(path, "/ch1/", 5) == 0)
+    return path + 4;
+  return path;
 }
 
 /**
@@ -419,8 +866,7 @@ void handle_debug(OSCMessage &msg) {
   if (msg.isString(0)) {
     char str[len];
     msg.getString(0, str, len);
-    Serial.print("ESP DEBUG:\t");
-    Serial.println(str);
+    debug_log.log("ESP DEBUG:\t%s", str);
   }
 }
 
@@ -436,11 +882,8 @@ void handle_set_port_local(OSCMessage &msg) {
       ip_bytes[i] = msg.getInt(i);
     ip_local = IPAddress(ip_bytes);
     port_local = msg.getInt(4);
-    Serial.print("UDP port (local):\t");
-    Serial.print(ip_local);
-    Serial.print("\t [");
-    Serial.print(port_local);
-    Serial.println("]");
+    debug_log.log("UDP port (local):\t%d.%d.%d.%d\t [%d]", ip_bytes[0], ip_bytes[1], 
+                  ip_bytes[2], ip_bytes[3], port_local);
   }
 }
 
@@ -456,11 +899,8 @@ void handle_set_port_multi(OSCMessage &msg) {
       ip_bytes[i] = msg.getInt(i);
     ip_multi = IPAddress(ip_bytes);
     port_multi = msg.getInt(4);
-    Serial.print("UDP port (multi):\t");
-    Serial.print(ip_multi);
-    Serial.print("\t [");
-    Serial.print(port_multi);
-    Serial.println("]");
+    debug_log.log("UDP port (multi):\t%d.%d.%d.%d\t [%d]", ip_bytes[0], ip_bytes[1], 
+                  ip_bytes[2], ip_bytes[3], port_multi);
   }
 }
 
@@ -475,14 +915,168 @@ void handle_remote_ip(OSCMessage &msg) {
     for (int i = 0; i < 4; i++) 
       ip_bytes[i] = msg.getInt(i);
     remote_ip = IPAddress(ip_bytes);
-    Serial.print("Setting remote IP = ");
-    Serial.print(ip_bytes[0]);
-    Serial.print('.');
-    Serial.print(ip_bytes[1]);
-    Serial.print('.');
-    Serial.print(ip_bytes[2]);
-    Serial.print('.');
-    Serial.println(ip_bytes[3]);
+    debug_log.log("Setting remote IP = %d.%d.%d.%d", ip_bytes[0], ip_bytes[1], ip_bytes[2], 
+                  ip_bytes[3]);
+  }
+}
+
+/**
+ * /heartbeat "ii" <interval_ms><port#>
+ * 
+ * Periodically send /heartbeat "if" <egen_state><egen_level> to the sender of this 
+ * message (most recent remote IP) on the given port. An interval of zero disables. With
+ * /synth/poly above 1, the state is the busiest voice's and the level the loudest's.
+ */
+void handle_heartbeat(OSCMessage &msg) {
+  if (msg.isInt(0) && msg.isInt(1)) {
+    int interval_ms = msg.getInt(0);
+    heartbeat_interval_ms = interval_ms > 0 ? interval_ms : 0;
+    heartbeat_port = msg.getInt(1);
+    heartbeat_ip = remote_ip;
+    if (heartbeat_interval_ms > 0)
+      scheduler.setPeriod(heartbeat_task, heartbeat_interval_ms * 1000);
+    scheduler.setEnabled(heartbeat_task, heartbeat_interval_ms > 0);
+  }
+}
+
+/**
+ * /telemetry "ii[iiii]" <interval_ms><port#>[<ip0><ip1><ip2><ip3>]
+ * 
+ * Periodically send the message plane counters (see send_telemetry()) to a collector on 
+ * the given port: the given IP, or else the sender of this message (most recent remote 
+ * IP). An interval of zero disables.
+ */
+void handle_telemetry(OSCMessage &msg) {
+  if (!msg.isInt(0) || !msg.isInt(1))
+    return;
+  int interval_ms = msg.getInt(0);
+  telemetry_port = msg.getInt(1);
+  telemetry_ip = remote_ip;
+  if (msg.isInt(2) && msg.isInt(3) && msg.isInt(4) && msg.isInt(5)) {
+    uint8_t ip_bytes[4];
+    for (int i = 0; i < 4; i++)
+      ip_bytes[i] = msg.getInt(2 + i);
+    telemetry_ip = IPAddress(ip_bytes);
+  }
+  if (interval_ms > 0)
+    scheduler.setPeriod(telemetry_task, interval_ms * 1000);
+  scheduler.setEnabled(telemetry_task, interval_ms > 0);
+}
+
+/**
+ * /esp/telemetry "iiiii" <udp_received><udp_errors><slip_errors><wifi_reconnects>
+ *   <loops_per_s>
+ * 
+ * The ESP8266's relay counters, sent over SLIP in reply to each /telemetry packet and
+ * forwarded in the next one.
+ */
+void handle_esp_telemetry(OSCMessage &msg) {
+  for (int i = 0; i < kEspNumFields; i++) {
+    if (msg.isInt(i))
+      telemetry.esp[i] = msg.getInt(i);
+  }
+}
+
+/**
+ * /stats/tasks "i" <port#>
+ * 
+ * Reply to the sender (most recent remote IP) on the given port with one message per 
+ * main loop task:
+ *   /stats/task "siiiii" <name><runs><deadline_misses><avg_us><max_us><max_latency_us>
+ */
+void handle_stats_tasks(OSCMessage &msg) {
+  if (!msg.isInt(0))
+    return;
+  for (int j = 0; j < 4; j++)
+    set_dest_out.set(j, (int)remote_ip[j]);
+  set_dest_out.set(4, msg.getInt(0));
+  for (int i = 0; i < scheduler.count(); i++) {
+    const TaskStats &stats = scheduler.getStats(i);
+    OSCMessage stats_out("/stats/task");
+    stats_out.add(scheduler.getName(i));
+    stats_out.add((int)stats.runs);
+    stats_out.add((int)stats.deadline_misses);
+    stats_out.add((int)(stats.runs > 0 ? stats.total_us / stats.runs : 0));
+    stats_out.add((int)stats.max_us);
+    stats_out.add((int)stats.max_latency_us);
+    slip_send(set_dest_out);
+    slip_send(stats_out);
+  }
+}
+
+/**
+ * /stats/reset
+ * 
+ * Clear main loop task and audio CPU load statistics.
+ */
+void handle_stats_reset(OSCMessage &msg) {
+  scheduler.resetStats();
+  for (int i = 0; i < num_load_meters; i++)
+    load_meters[i]->reset();
+#ifdef AUDIO_GRAPH_ENGINE
+  graph_overruns = 0;
+#endif
+}
+
+/**
+ * /stats/audio "i" <port#>
+ * 
+ * Reply to the sender (most recent remote IP) on the given port with the measured CPU 
+ * load of each audio interrupt in the compiled engine (load as a fraction of CPU time, and
+ * the mean cycles per run: per sample for the 8 kHz interrupt, per block for the graph):
+ *   /stats/audio "siffii" <name><sample_rate><load><max_load><peak_us><avg_cycles>
+ * The graph engine also reports dropped blocks:
+ *   /stats/audio/overruns "i" <count>
+ */
+void handle_stats_audio(OSCMessage &msg) {
+  if (!msg.isInt(0))
+    return;
+  for (int j = 0; j < 4; j++)
+    set_dest_out.set(j, (int)remote_ip[j]);
+  set_dest_out.set(4, msg.getInt(0));
+  for (int i = 0; i < num_load_meters; i++) {
+    OSCMessage load_out("/stats/audio");
+    load_out.add(load_meters[i]->getName());
+    load_out.add((int)fs);
+    load_out.add(load_meters[i]->getLoad());
+    load_out.add(load_meters[i]->getMaxLoad());
+    load_out.add((int)load_meters[i]->getPeakUs());
+    load_out.add((int)load_meters[i]->getAvgCycles());
+    slip_send(set_dest_out);
+    slip_send(load_out);
+  }
+#ifdef AUDIO_GRAPH_ENGINE
+  OSCMessage overruns_out("/stats/audio/overruns");
+  overruns_out.add((int)graph_overruns);
+  slip_send(set_dest_out);
+  slip_send(overruns_out);
+#endif
+}
+
+/**
+ * /stats/fastmath "i" <port#>
+ * 
+ * Benchmark the fast math kernels against the libm calls they replace and reply to the 
+ * sender (most recent remote IP) on the given port with one message per kernel:
+ *   /stats/fastmath "sfff" <name><fast_cycles><libm_cycles><max_error>
+ * Cycles are per call. Blocks the main loop for a few milliseconds.
+ */
+void handle_stats_fastmath(OSCMessage &msg) {
+  if (!msg.isInt(0))
+    return;
+  FastMathBenchResult results[8];
+  int n = fastMathBenchmark(results, 8);
+  for (int j = 0; j < 4; j++)
+    set_dest_out.set(j, (int)remote_ip[j]);
+  set_dest_out.set(4, msg.getInt(0));
+  for (int i = 0; i < n; i++) {
+    OSCMessage bench_out("/stats/fastmath");
+    bench_out.add(results[i].name);
+    bench_out.add(results[i].fast_cycles);
+    bench_out.add(results[i].libm_cycles);
+    bench_out.add(results[i].max_error);
+    slip_send(set_dest_out);
+    slip_send(bench_out);
   }
 }
 
@@ -548,21 +1142,26 @@ void handle_mute(OSCMessage &msg) {
 /**
  * /note "ii" <num><vel>
  * 
- * MIDI-ish note on/off message containing note number and velocity.
+ * MIDI-ish note on/off message containing note number and velocity. With /synth/poly above
+ * 1, each note takes a voice from the channel's pool and note off releases that note.
  */
 void handle_note(OSCMessage &msg) {
   if (msg.isInt(0) && msg.isInt(1)) {
-    if (msg.getInt(1) == 0)     // Note OFF
-      egen.gate(false);
+    int nn = msg.getInt(0);
+    if (msg.getInt(1) == 0) {   // Note OFF
+      noInterrupts();
+      osc_ch->noteOff(nn);
+      interrupts();
+    }
     else {                      // Note ON
-      int nn = msg.getInt(0);
       int vel = msg.getInt(1);
-      float f0 = pow(2, (nn - 69) / 12.0) * 440.0;
-      vco.setF0(f0);
-      egen.setSustainLevel(vel / 127.0);
-      egen.gate(true);
-      gate_remote_ip = remote_ip;
-      propagating = false;
+      noInterrupts();
+      osc_ch->noteOn(nn, fastMtof(nn), vel / 127.0f);
+      interrupts();
+      if (osc_ch == &ch1) {     // Only channel 1 propagates
+        gate_remote_ip = remote_ip;
+        propagating = false;
+      }
     }
   }
 }
@@ -577,10 +1176,13 @@ void handle_note(OSCMessage &msg) {
  */
 void handle_propagate(OSCMessage &msg) {
   if (msg.isFloat(0)) {
+    telemetry.prop_received++;
     propagate_sus_level = msg.getFloat(0);
-    previous_sus_level = egen.getSustain();   
-    egen.setSustainLevel(propagate_sus_level);
-    egen.gate(true);
+    previous_sus_level = ch1.egen.getSustain();   
+    noInterrupts();
+    ch1.egen.setSustainLevel(propagate_sus_level);
+    ch1.egen.gate(true);
+    interrupts();
     
     if (propagating && remote_ip != gate_remote_ip)
       gate_remote_ip = IPAddress(0, 0, 0, 0);
@@ -617,7 +1219,9 @@ void handle_propagate_enable(OSCMessage &msg) {
  */
 void handle_propagate_kill(OSCMessage &msg) {
   kill_received = true;
-  egen.gate(false);
+  noInterrupts();
+  ch1.egen.gate(false);
+  interrupts();
 }
 
 void handle_propagate_reflect(OSCMessage &msg) {
@@ -632,19 +1236,27 @@ void handle_propagate_reflect(OSCMessage &msg) {
 /**
  * /mod/lfo/wave_shape "s" <shape>
  * 
- * Set LFO waveform {"sine", "square", "saw"}
+ * Set LFO waveform {"sine", "square", "saw", "user"}
  */
 void mod_handle_lfo_wave_shape(OSCMessage &msg) {
   int len = msg.getDataLength(0);
   if (msg.isString(0) && len < 8) {
-    char shape[len];
-    msg.getString(0, shape, len);
-    if (strcmp(shape, "sine") == 0)
-      lfo.setWaveShape(kWaveShapeSine);
-    else if (strcmp(shape, "square") == 0)
-      lfo.setWaveShape(kWaveShapeSquare);
-    else if (strcmp(shape, "saw") == 0)
-      lfo.setWaveShape(kWaveShapeSaw);
+    char shape_str[len];
+    msg.getString(0, shape_str, len);
+    WaveShape shape;
+    if (strcmp(shape_str, "sine") == 0)
+      shape = kWaveShapeSine;
+    else if (strcmp(shape_str, "square") == 0)
+      shape = kWaveShapeSquare;
+    else if (strcmp(shape_str, "saw") == 0)
+      shape = kWaveShapeSaw;
+    else if (strcmp(shape_str, "user") == 0)
+      shape = kWaveShapeUser;
+    else
+      return;
+    noInterrupts();
+    lfo.setWaveShape(shape);
+    interrupts();
   }
 }
 
@@ -655,20 +1267,55 @@ void mod_handle_lfo_wave_shape(OSCMessage &msg) {
  */
 void mod_handle_lfo_rate(OSCMessage &msg) {
   if (msg.isFloat(0)) {
+    noInterrupts();
     lfo.setF0(msg.getFloat(0));
-    Serial.print("-- ");
-    Serial.println(msg.getFloat(0));
+    interrupts();
   }
 }
 
 /**
  * /mod/lfo/env_mod "f" <amount>
  * 
- * Scalar dictating how much the envelope generator modulates the LFO rate.
+ * How much the (CH1) envelope generator modulates the LFO rate, in octaves. Shorthand for
+ * the egen1 -> lfo modulation matrix route.
  */
 void mod_handle_lfo_env_mod(OSCMessage &msg) {
   if (msg.isFloat(0))
-    lfo.setF0ModAmp(msg.getFloat(0));
+    mod_matrix.setRoute(kModSrcEgen1, kModDstLfoPitch, msg.getFloat(0));
+}
+
+/**
+ * /mod/matrix/route "ssf" <source><destination><amount>
+ * 
+ * Set the amount of a modulation route, or remove it with an amount of zero. 
+ *   Sources: "lfo" [-1, 1], "egen1", "egen2", "follower", "cv1", "cv2", "cv3" [0, 1]
+ *   Destinations: "vco1", "vco2", "lfo" (pitch in octaves), "vca1", "vca2" (output 
+ *   gain offset), "fb_gain" (input gain offset), "delay" (samples), "gate_thresh" 
+ *   (follower gate threshold offset)
+ */
+void mod_handle_matrix_route(OSCMessage &msg) {
+  char src_name[12];
+  char dst_name[12];
+  if (!msg.isString(0) || !msg.isString(1) || !msg.isFloat(2) || 
+      msg.getDataLength(0) > 12 || msg.getDataLength(1) > 12)
+    return;
+  msg.getString(0, src_name, 12);
+  msg.getString(1, dst_name, 12);
+  int src = ModMatrix::findSource(src_name);
+  int dst = ModMatrix::findDest(dst_name);
+  if (src < 0 || dst < 0)
+    debug_log.log("/mod/matrix/route: unknown source or destination");
+  else if (!mod_matrix.setRoute((ModSource)src, (ModDest)dst, msg.getFloat(2)))
+    debug_log.log("/mod/matrix/route: too many routes");
+}
+
+/**
+ * /mod/matrix/clear
+ * 
+ * Remove all modulation routes.
+ */
+void mod_handle_matrix_clear(OSCMessage &msg) {
+  mod_matrix.clear();
 }
 
 /**
@@ -677,8 +1324,12 @@ void mod_handle_lfo_env_mod(OSCMessage &msg) {
  * Envelope generator attack time in seconds.
  */
 void mod_handle_egen_atk(OSCMessage &msg) {
-  if (msg.isFloat(0))
-    egen.setAttackTime(msg.getFloat(0));
+  if (msg.isFloat(0)) {
+    noInterrupts();
+    for (int v = 0; v < VOICE_POOL_SIZE; v++)
+      osc_ch->voices[v].egen.setAttackTime(msg.getFloat(0));
+    interrupts();
+  }
 }
 
 /**
@@ -687,8 +1338,12 @@ void mod_handle_egen_atk(OSCMessage &msg) {
  * Envelope generator sustain level (recommended [0, 1])
  */
 void mod_handle_egen_sus(OSCMessage &msg) {
-  if (msg.isFloat(0))
-    egen.setSustainLevel(msg.getFloat(0));
+  if (msg.isFloat(0)) {
+    noInterrupts();
+    for (int v = 0; v < VOICE_POOL_SIZE; v++)
+      osc_ch->voices[v].egen.setSustainLevel(msg.getFloat(0));
+    interrupts();
+  }
 }
 
 /**
@@ -697,8 +1352,12 @@ void mod_handle_egen_sus(OSCMessage &msg) {
  * Envelope generator release time in seconds.
  */
 void mod_handle_egen_rel(OSCMessage &msg) {
-  if (msg.isFloat(0))
-    egen.setReleaseTime(msg.getFloat(0));
+  if (msg.isFloat(0)) {
+    noInterrupts();
+    for (int v = 0; v < VOICE_POOL_SIZE; v++)
+      osc_ch->voices[v].egen.setReleaseTime(msg.getFloat(0));
+    interrupts();
+  }
 }
 
 /**
@@ -708,8 +1367,12 @@ void mod_handle_egen_rel(OSCMessage &msg) {
  * releases immediately. 
  */
 void mod_handle_egen_do_sus(OSCMessage &msg) {
-  if (msg.isInt(0))
-    egen.setSustain(msg.getInt(0) != 0);
+  if (msg.isInt(0)) {
+    noInterrupts();
+    for (int v = 0; v < VOICE_POOL_SIZE; v++)
+      osc_ch->voices[v].egen.setSustain(msg.getInt(0) != 0);
+    interrupts();
+  }
 }
 
 /**
@@ -720,7 +1383,7 @@ void mod_handle_egen_do_sus(OSCMessage &msg) {
  */
 void mod_handle_egen_follower_gate(OSCMessage &msg) {
   if (msg.isInt(0))
-    follower_gate_enabled = msg.getInt(0) == 1;
+    osc_ch->follower_gate = msg.getInt(0) == 1;
 }
 
 /**
@@ -730,10 +1393,58 @@ void mod_handle_egen_follower_gate(OSCMessage &msg) {
  */
 void mod_handle_egen_gate(OSCMessage &msg) {
   if (msg.isInt(0)) {
-    egen.gate(msg.getInt(0) != 0);
-    gate_remote_ip = remote_ip;
-    propagating = false;
+    noInterrupts();
+    osc_ch->egen.gate(msg.getInt(0) != 0);
+    interrupts();
+    if (osc_ch == &ch1) {
+      gate_remote_ip = remote_ip;
+      propagating = false;
+    }
+  }
+}
+
+/**
+ * /mod/egen/shape "i[ffi]..." <sustain_point>[<time_ms><level><ramp>]...
+ * 
+ * Replace the envelope generator's attack and release with a breakpoint shape of up to 
+ * EGEN_MAX_SEGMENTS segments, each ramping from the previous level (zero for the first)
+ * to <level> over <time_ms>, linearly (ramp 0) or exponentially (ramp 1). A segment with
+ * the previous segment's level holds. Segments up to <sustain_point> play on gate on and
+ * hold its level until gate off; the rest play on gate off. With a sustain point of -1,
+ * the first segment is the attack and the rest play immediately after it. Levels are
+ * relative to the sustain level (note velocity). With no segments, restores the attack
+ * and release.
+ */
+void mod_handle_egen_shape(OSCMessage &msg) {
+
+  float times_ms[EGEN_MAX_SEGMENTS];
+  float levels[EGEN_MAX_SEGMENTS];
+  EnvelopeRamp ramps[EGEN_MAX_SEGMENTS];
+
+  int msg_size = msg.size();
+  int n = (msg_size - 1) / 3;
+  if (!msg.isInt(0) || (msg_size - 1) % 3 != 0 || n > EGEN_MAX_SEGMENTS) {
+    debug_log.log("/mod/egen/shape: bad shape");
+    return;
   }
+  for (int i = 0; i < n; i++) {
+    int j = 1 + 3*i;
+    if (!msg.isFloat(j) || !msg.isFloat(j+1) || !msg.isInt(j+2)) {
+      debug_log.log("/mod/egen/shape: bad segment %d", i);
+      return;
+    }
+    times_ms[i] = msg.getFloat(j);
+    levels[i] = msg.getFloat(j+1);
+    ramps[i] = msg.getInt(j+2) ? kEnvelopeRamp_Exponential : kEnvelopeRamp_Linear;
+  }
+
+  bool ok = true;
+  noInterrupts();
+  for (int v = 0; v < VOICE_POOL_SIZE; v++)
+    ok = osc_ch->voices[v].egen.setBreakpoints(times_ms, levels, ramps, n, msg.getInt(0));
+  interrupts();
+  if (!ok)
+    debug_log.log("/mod/egen/shape: bad sustain point");
 }
 
 /* ------------------------ */
@@ -743,40 +1454,133 @@ void mod_handle_egen_gate(OSCMessage &msg) {
 /**
  * /synth/vco/wave_shape "s" <shape>
  * 
- * Set VCO waveform {"sine", "square", "saw"}
+ * Set VCO waveform {"sine", "square", "saw", "user"}. Ends morphing.
  */
 void synth_handle_vco_wave_shape(OSCMessage &msg) {
   int len = msg.getDataLength(0);
   if (msg.isString(0) && len < 8) {
-    char shape[len];
-    msg.getString(0, shape, len);
-    if (strcmp(shape, "sine") == 0)
-      vco.setWaveShape(kWaveShapeSine);
-    else if (strcmp(shape, "square") == 0)
-      vco.setWaveShape(kWaveShapeSquare);
-    else if (strcmp(shape, "saw") == 0)
-      vco.setWaveShape(kWaveShapeSaw);
+    char shape_str[len];
+    msg.getString(0, shape_str, len);
+    WaveShape shape;
+    if (strcmp(shape_str, "sine") == 0)
+      shape = kWaveShapeSine;
+    else if (strcmp(shape_str, "square") == 0)
+      shape = kWaveShapeSquare;
+    else if (strcmp(shape_str, "saw") == 0)
+      shape = kWaveShapeSaw;
+    else if (strcmp(shape_str, "user") == 0)
+      shape = kWaveShapeUser;
+    else
+      return;
+    noInterrupts();
+    for (int v = 0; v < VOICE_POOL_SIZE; v++)
+      osc_ch->voices[v].vco.setWaveShape(shape);
+    interrupts();
+  }
+}
+
+/**
+ * /synth/vco/morph "f" <position>
+ * 
+ * Morph the VCO continuously across sine (0), square (1), saw (2) and the user table (3),
+ * crossfading between the shapes either side of the position.
+ */
+void synth_handle_vco_morph(OSCMessage &msg) {
+  if (msg.isFloat(0)) {
+    noInterrupts();
+    for (int v = 0; v < VOICE_POOL_SIZE; v++)
+      osc_ch->voices[v].vco.setMorph(msg.getFloat(0));
+    interrupts();
+  }
+}
+
+/**
+ * /synth/vco/table "ib" <chunk><samples>
+ * 
+ * Upload one chunk of the user wave table: WAVE_UPLOAD_CHUNK little-endian float32 
+ * samples [-1.0, 1.0] starting at chunk * WAVE_UPLOAD_CHUNK. The blob is read straight 
+ * into the staging table. Chunks may arrive in any order or be resent; once all 
+ * WAVE_UPLOAD_CHUNKS have arrived the table is swapped in at the next audio block, for 
+ * both channels.
+ */
+void synth_handle_vco_table(OSCMessage &msg) {
+  if (!msg.isInt(0) || !msg.isBlob(1) || msg.getDataLength(1) != WAVE_UPLOAD_CHUNK_BYTES) {
+    debug_log.log("/synth/vco/table: expected \"ib\" with %d bytes", WAVE_UPLOAD_CHUNK_BYTES);
+    return;
+  }
+  int chunk = msg.getInt(0);
+  uint8_t *dst = wave_upload.stage(chunk);
+  if (dst == NULL) {
+    debug_log.log("/synth/vco/table: chunk %d rejected", chunk);
+    return;
+  }
+  msg.getBlob(1, dst, WAVE_UPLOAD_CHUNK_BYTES);
+  if (wave_upload.commitChunk(chunk))
+    debug_log.log("/synth/vco/table: table complete");
+}
+
+/**
+ * /synth/poly "i" <voices>
+ * 
+ * Number of voices notes are allocated from [1, VOICE_POOL_SIZE]. 1 (default) plays every
+ * note on the channel's one voice; more let a node sound chords, stealing the quietest 
+ * releasing voice, then the oldest, when all are busy. Sounding voices are mixed at 
+ * 1/(number sounding), so a single note plays at the same level at any setting.
+ */
+void synth_handle_poly(OSCMessage &msg) {
+  if (msg.isInt(0)) {
+    noInterrupts();
+    osc_ch->setPoly(msg.getInt(0));
+    interrupts();
   }
 }
 
 /**
  * /synth/vco/freq "f" <freq>
  * 
- * Set the VCO frequency in Hz.
+ * Set the VCO frequency in Hz, gliding from the current frequency if a glide time is set.
  */
 void synth_handle_vco_freq(OSCMessage &msg) {
-  if (msg.isFloat(0))
-    vco.setF0(msg.getFloat(0));
+  if (msg.isFloat(0)) {
+    noInterrupts();
+    for (int v = 0; v < VOICE_POOL_SIZE; v++)
+      osc_ch->voices[v].vco.setF0(msg.getFloat(0));
+    interrupts();
+  }
+}
+
+/**
+ * /synth/vco/glide "f[s]" <time_ms>[<mode>]
+ * 
+ * Portamento time for VCO frequency changes (notes and /synth/vco/freq); zero disables.
+ * Mode "lin" (default) glides linearly in Hz, "exp" linearly in pitch.
+ */
+void synth_handle_vco_glide(OSCMessage &msg) {
+  if (!msg.isFloat(0))
+    return;
+  GlideMode mode = kGlideLinear;
+  if (msg.isString(1) && msg.getDataLength(1) <= 4) {
+    char mode_str[4];
+    msg.getString(1, mode_str, 4);
+    if (strcmp(mode_str, "exp") == 0)
+      mode = kGlideExponential;
+  }
+  noInterrupts();
+  for (int v = 0; v < VOICE_POOL_SIZE; v++)
+    osc_ch->voices[v].vco.setGlide(msg.getFloat(0), mode);
+  interrupts();
 }
 
 /**
  * /synth/vco/lfo_mod "f" <amount>
  * 
- * Scalar dictating how much the LFO modulates the VCO frequency.
+ * How much the LFO modulates the VCO frequency, in octaves. Shorthand for the lfo -> vco1
+ * (or vco2) modulation matrix route.
  */
 void synth_handle_vco_lfo_mod(OSCMessage &msg) {
   if (msg.isFloat(0))
-    vco.setF0ModAmp(msg.getFloat(0));
+    mod_matrix.setRoute(kModSrcLfo, osc_ch == &ch2 ? kModDstVco2Pitch : kModDstVco1Pitch, 
+                        msg.getFloat(0));
 }
 
 /**
@@ -785,8 +1589,12 @@ void synth_handle_vco_lfo_mod(OSCMessage &msg) {
  * Scalar dictating how much the LFO modulates the VCA amplitude.
  */
 void synth_handle_vca_lfo_mod(OSCMessage &msg) {
-  if (msg.isFloat(0))
-    synth_vca_lfo_mod = msg.getFloat(0);
+  if (msg.isFloat(0)) {
+    osc_ch->vca_lfo_mod = msg.getFloat(0);
+    // Brighten the bulb to compensate for the LFO's average attenuation
+    if (osc_ch == &ch1)
+      leds.setNoteBoost(ch1.vca_lfo_mod < 0.99f ? 1.0f / (1.0f - ch1.vca_lfo_mod) : 100.0f);
+  }
 }
 
 /* --------------------------------- */
@@ -810,8 +1618,10 @@ void fb_handle_gain(OSCMessage &msg) {
  * audio output lags the input.
  */
 void fb_handle_phase(OSCMessage &msg) {
-  if (msg.isFloat(0))
+  if (msg.isFloat(0)) {
     sample_delay = msg.getFloat(0);
+    mod_matrix.refresh(kModDstDelay);     // Applied with modulation at the next control block
+  }
 }
 
 /**
@@ -845,6 +1655,155 @@ void mixer_handle_synth_feedback_mix(OSCMessage &msg) {
     fb_mix = msg.getFloat(0);
 }
 
+/* ------------------ */
+/* === LED output === */
+/* ------------------ */
+
+/**
+ * /led/color/gated "fff" <red><green><blue>
+ * 
+ * Bulb color (scaled by the EGEN level) when the envelope was gated by the input
+ * follower. Components nominally [0, 1].
+ */
+void led_handle_color_gated(OSCMessage &msg) {
+  if (msg.isFloat(0) && msg.isFloat(1) && msg.isFloat(2))
+    leds.setGatedColor(msg.getFloat(0), msg.getFloat(1), msg.getFloat(2));
+}
+
+/**
+ * /led/color/note "fff" <red><green><blue>
+ * 
+ * Bulb color (scaled by the EGEN level) when the envelope was gated by a note, gate or 
+ * propagation message.
+ */
+void led_handle_color_note(OSCMessage &msg) {
+  if (msg.isFloat(0) && msg.isFloat(1) && msg.isFloat(2))
+    leds.setNoteColor(msg.getFloat(0), msg.getFloat(1), msg.getFloat(2));
+}
+
+/**
+ * /led/gamma "f" <gamma>
+ * 
+ * Gamma applied to all LED levels (1.0 is linear).
+ */
+void led_handle_gamma(OSCMessage &msg) {
+  if (msg.isFloat(0))
+    leds.setGamma(msg.getFloat(0));
+}
+
+/**
+ * /led/brightness "f" <brightness>
+ * 
+ * Overall LED brightness [0, 1].
+ */
+void led_handle_brightness(OSCMessage &msg) {
+  if (msg.isFloat(0))
+    leds.setBrightness(msg.getFloat(0));
+}
+
+/* ------------------- */
+/* === Audio graph === */
+/* ------------------- */
+#ifdef AUDIO_GRAPH_ENGINE
+
+/**
+ * /graph/clear
+ * 
+ * Start a new pending graph. The running graph is unchanged until /graph/commit.
+ */
+void graph_handle_clear(OSCMessage &msg) {
+  graph.clear();
+}
+
+/**
+ * /graph/node "ss[f]" <name><type>[<amount>]
+ * 
+ * Add a node to the pending graph. Type is "input" (audio input), "vca", "mix", or one of
+ * the DSP objects "follower", "egen1", "egen2", "lfo", "vco1", "vco2", "delay", "voices1",
+ * "voices2" (each usable once; a voices node adds a channel's other voices to voice 0).
+ * Amount is the VCA depth or mix [0, 1], default 1.
+ */
+void graph_handle_node(OSCMessage &msg) {
+  char name[GRAPH_NAME_LEN];
+  char type[GRAPH_NAME_LEN];
+  if (!msg.isString(0) || !msg.isString(1) || msg.getDataLength(0) > GRAPH_NAME_LEN || 
+      msg.getDataLength(1) > GRAPH_NAME_LEN)
+    return;
+  msg.getString(0, name, GRAPH_NAME_LEN);
+  msg.getString(1, type, GRAPH_NAME_LEN);
+  if (!graph.addNode(name, type, msg.isFloat(2) ? msg.getFloat(2) : 1.0f))
+    debug_log.log("/graph/node: %s", graph.getError());
+}
+
+/**
+ * /graph/connect "ssi" <src><dst><input#>
+ * 
+ * Connect a node's output to an input of another node in the pending graph. Inputs are 
+ * 0: audio (follower, delay, VCA), gate CV (envelope) or a (mix); 1: modulator (VCA) or 
+ * b (mix).
+ */
+void graph_handle_connect(OSCMessage &msg) {
+  char src[GRAPH_NAME_LEN];
+  char dst[GRAPH_NAME_LEN];
+  if (!msg.isString(0) || !msg.isString(1) || !msg.isInt(2) || 
+      msg.getDataLength(0) > GRAPH_NAME_LEN || msg.getDataLength(1) > GRAPH_NAME_LEN)
+    return;
+  msg.getString(0, src, GRAPH_NAME_LEN);
+  msg.getString(1, dst, GRAPH_NAME_LEN);
+  if (!graph.connect(src, dst, msg.getInt(2)))
+    debug_log.log("/graph/connect: %s", graph.getError());
+}
+
+/**
+ * /graph/output "si" <name><channel>
+ * 
+ * Route a node of the pending graph to a DAC channel (0 or 1).
+ */
+void graph_handle_output(OSCMessage &msg) {
+  char name[GRAPH_NAME_LEN];
+  if (!msg.isString(0) || !msg.isInt(1) || msg.getDataLength(0) > GRAPH_NAME_LEN)
+    return;
+  msg.getString(0, name, GRAPH_NAME_LEN);
+  if (!graph.setOutput(name, msg.getInt(1)))
+    debug_log.log("/graph/output: %s", graph.getError());
+}
+
+/**
+ * /graph/amount "sf" <name><amount>
+ * 
+ * Set the depth of a VCA or the mix of a mixer, in the pending and running graphs.
+ */
+void graph_handle_amount(OSCMessage &msg) {
+  char name[GRAPH_NAME_LEN];
+  if (!msg.isString(0) || !msg.isFloat(1) || msg.getDataLength(0) > GRAPH_NAME_LEN)
+    return;
+  msg.getString(0, name, GRAPH_NAME_LEN);
+  if (!graph.setAmount(name, msg.getFloat(1)))
+    debug_log.log("/graph/amount: %s", graph.getError());
+}
+
+/**
+ * /graph/commit
+ * 
+ * Compile the pending graph and swap it in at the next block boundary. On error (unknown 
+ * node or a cycle) the running graph is kept.
+ */
+void graph_handle_commit(OSCMessage &msg) {
+  if (!graph.commit())
+    debug_log.log("/graph/commit: %s", graph.getError());
+}
+
+/**
+ * /graph/default
+ * 
+ * Restore and commit the default graph (the per-sample engine's chain).
+ */
+void graph_handle_default(OSCMessage &msg) {
+  audio_graph_default();
+}
+
+#endif
+
 /* === Utility === */
 void slip_send(OSCMessage &msg) {
   SLIPSerial.beginPacket();
@@ -1,4 +1,6 @@
 #include "EnvelopeFollower.h"
+#include "FastMath.h"
+#pragma GCC diagnostic error "-Wdouble-promotion"
 
 EnvelopeFollower::EnvelopeFollower(float sampleRate, float atk_ms, float rel_ms) 
 : fs(sampleRate), value(0.0f) {
@@ -9,16 +11,16 @@ EnvelopeFollower::EnvelopeFollower(float sampleRate, float atk_ms, float rel_ms)
 EnvelopeFollower::~EnvelopeFollower() {}
 
 void EnvelopeFollower::setAttackTime(float atk_ms) {
-  atk_tau = exp(-1 / (fs*atk_ms/1000.0f));
+  atk_tau = fastOnePoleCoef(fs*atk_ms/1000.0f);
 }
 
 void EnvelopeFollower::setReleaseTime(float rel_ms) {
-  rel_tau = exp(-1 / (fs*rel_ms/1000.0f));
+  rel_tau = fastOnePoleCoef(fs*rel_ms/1000.0f);
 }
 
 float EnvelopeFollower::process(float sample) {
   
-  sample = fabs(sample); 
+  sample = fabsf(sample); 
 
   if(value < sample) 
     value = sample + atk_tau*(value-sample);
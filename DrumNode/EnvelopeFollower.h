@@ -9,7 +9,7 @@
 #include <stdlib.h>
 #include <math.h>
 
-#define SCALE (4.0)
+#define SCALE (4.0f)
 
 class EnvelopeFollower {
 
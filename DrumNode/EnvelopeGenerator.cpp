@@ -1,8 +1,11 @@
 #include "EnvelopeGenerator.h"
+#include "FastMath.h"
+#pragma GCC diagnostic error "-Wdouble-promotion"
 
 EnvelopeGenerator::EnvelopeGenerator(float sampleRate, float atk_ms, float sus, float rel_ms) 
 : level(0.0), sustain_level(EGEN_MAX), do_sustain(false), state(kEnvelopeState_Idle), ramp(kEnvelopeRamp_Linear), 
-  fs(sampleRate), gate_on_thresh(0.5), gate_off_thresh(0.3), cv_gate(true), was_cv_gated(false), falling_edge(false) {
+  curve(kEnvelopeRamp_Linear), exponential_multiplier(1.0), linear_slope(0.0), target(0.0), direction(0),
+  hold_remaining(0), num_segments(0), sustain_segment(-1), release_segment(0), segment(0), fs(sampleRate), gate_on_thresh(0.5), gate_off_thresh(0.3), cv_gate(true), was_cv_gated(false), falling_edge(false) {
   setAttackTime(atk_ms);
   setReleaseTime(rel_ms);
 }
@@ -14,13 +17,19 @@ EnvelopeGenerator::~EnvelopeGenerator() {}
  * re-computer the multiplier.
  */
 void EnvelopeGenerator::setAttackTime(float atk_ms) {
-  atk_time_samples = atk_ms*fs/1000.0;
-  if (state == kEnvelopeState_Attack) 
+  atk_time_samples = atk_ms*fs*0.001f;
+  if (state == kEnvelopeState_Attack && num_segments == 0) 
     computeRamp(level, sustain_level, atk_time_samples);
 }
 
+/**
+ * Set the sustain level, or the amplitude of a breakpoint shape (applied from the next
+ * segment).
+ */
 void EnvelopeGenerator::setSustainLevel(float sus_level) {
   sustain_level = sus_level;
+  if (num_segments == 0 && (state == kEnvelopeState_Attack || state == kEnvelopeState_Sustain))
+    target = sus_level;
 }
 
 /** 
@@ -28,8 +37,8 @@ void EnvelopeGenerator::setSustainLevel(float sus_level) {
  * re-computer the multiplier.
  */
 void EnvelopeGenerator::setReleaseTime(float rel_ms) {
-  rel_time_samples = rel_ms*fs/1000.0;
-  if (state == kEnvelopeState_Release)
+  rel_time_samples = rel_ms*fs*0.001f;
+  if (state == kEnvelopeState_Release && num_segments == 0)
     computeRamp(level, EGEN_MIN, rel_time_samples);
 }
 
@@ -66,6 +75,54 @@ void EnvelopeGenerator::setGateOffThresh(float thresh) {
   gate_off_thresh = thresh;
 }
 
+/**
+ * Set a breakpoint shape of n segments, replacing the attack and release (n = 0 restores
+ * them). Each segment ramps from the previous segment's target (zero for the first) to its
+ * own over its time; a segment whose target equals the previous one holds. The step of
+ * each segment is computed here, so rendering costs the same for any number of segments.
+ * Returns false if the shape is invalid.
+ */
+bool EnvelopeGenerator::setBreakpoints(const float *times_ms, const float *targets, 
+                                       const EnvelopeRamp *ramps, int n, int sustain_point) {
+
+  if (n < 0 || n > EGEN_MAX_SEGMENTS || (n > 0 && sustain_point >= n))
+    return false;
+
+  float from = 0.0;
+  for (int i = 0; i < n; i++) {
+    EnvelopeSegment &seg = segments[i];
+    float to = targets[i];
+    float samples = times_ms[i]*fs*0.001f;
+    if (samples < 1)
+      samples = 1;
+    seg.ramp = ramps[i];
+    if (seg.ramp == kEnvelopeRamp_Exponential) {
+      if (to < EGEN_MIN) to = EGEN_MIN;
+      if (from < EGEN_MIN) from = EGEN_MIN;
+    }
+    seg.target = to;
+    seg.hold_samples = (int)samples;
+    if (to == from) {
+      seg.direction = 0;
+      seg.ramp = kEnvelopeRamp_Linear;
+      seg.step = 0.0;
+    }
+    else {
+      seg.direction = to > from ? 1 : -1;
+      if (seg.ramp == kEnvelopeRamp_Linear)
+        seg.step = (to - from) / samples;
+      else
+        seg.step = fastExp2(fastLog2(to / from) / samples);
+    }
+    from = to;
+  }
+
+  num_segments = n;
+  sustain_segment = sustain_point < 0 ? -1 : sustain_point;
+  release_segment = sustain_point < 0 ? 1 : sustain_point + 1;
+  return true;
+}
+
 /** 
  *  Gate the envelope generator with a 'CV' signal on interval [0.0, 1.0].
  *  - Gate ON if the input CV exceeds gate_on_thresh
@@ -91,31 +148,120 @@ void EnvelopeGenerator::gate_cv(float cv) {
 }
 
 /**
- * Trigger attack (true) or release (false) states and compute the multiplier.
+ * Trigger attack (true) or release (false) states and compute the multiplier. The state
+ * is written last, after the ramp it selects.
  */
 void EnvelopeGenerator::gate(bool on) {
   if (on) {
     was_cv_gated = false;
+    if (num_segments > 0)
+      enterSegment(0);
+    else {
+      target = sustain_level;
+      direction = 1;
+      computeRamp(level, sustain_level, atk_time_samples);  // Current level -> max level
+    }
     state = kEnvelopeState_Attack;
-    computeRamp(level, sustain_level, atk_time_samples);  // Current level -> max level
   }
   else {
-    state = kEnvelopeState_Release;
+    if (num_segments > 0) {
+      // Only a shape that's still before its release has one to play; a note off in
+      // release or idle would replay the tail
+      if (state != kEnvelopeState_Attack && state != kEnvelopeState_Sustain)
+        return;
+      if (release_segment < num_segments) {
+        enterSegment(release_segment);
+        state = kEnvelopeState_Release;
+      }
+      else
+        state = kEnvelopeState_Idle;
+      return;
+    }
+    target = EGEN_MIN;
+    direction = -1;
     computeRamp(level, EGEN_MIN, rel_time_samples);  // Current level -> min level
+    state = kEnvelopeState_Release;
+  }
+}
+
+/**
+ * Start breakpoint segment i from the current level, scaling it by the sustain level.
+ */
+void EnvelopeGenerator::enterSegment(int i) {
+  const EnvelopeSegment &seg = segments[i];
+  segment = i;
+  curve = seg.ramp;
+  target = seg.target * sustain_level;
+  direction = seg.direction;
+  hold_remaining = seg.hold_samples;
+  if (curve == kEnvelopeRamp_Linear)
+    linear_slope = seg.step * sustain_level;
+  else {
+    exponential_multiplier = seg.step;
+    if (level < EGEN_MIN * sustain_level)
+      level = EGEN_MIN * sustain_level;
   }
 }
 
+/**
+ * Whether the current segment has reached its target (or a hold has elapsed). A ramp that
+ * didn't move toward its target started at or past it (an attack re-gated at or above the
+ * sustain level), or is too close for its step to change the level.
+ */
+bool EnvelopeGenerator::passedTarget() {
+  if (direction > 0)
+    return level > target || level <= level_previous;
+  if (direction < 0)
+    return level <= target || level >= level_previous;
+  return --hold_remaining <= 0;
+}
+
+/**
+ * Clamp to the current segment's target and move to the next state: sustain or release
+ * after an attack, idle after a release, or the next breakpoint segment.
+ */
+void EnvelopeGenerator::endSegment() {
+
+  level = target;
+
+  if (num_segments == 0) {
+    if (state == kEnvelopeState_Attack) {
+      if (do_sustain)
+        state = kEnvelopeState_Sustain;
+      else
+        gate(false);
+    }
+    else
+      state = kEnvelopeState_Idle;
+    return;
+  }
+
+  int next = segment + 1;
+  if (state == kEnvelopeState_Attack && next == release_segment) {
+    if (sustain_segment >= 0) {
+      state = kEnvelopeState_Sustain;
+      return;
+    }
+    state = kEnvelopeState_Release;
+  }
+  if (next >= num_segments)
+    state = kEnvelopeState_Idle;
+  else
+    enterSegment(next);
+}
+
 /**
  * Compute the slope or multiplier to reach level a1 from level a0 in the specified
  * number of samples, depending on the current ramp mode.
  */
 void EnvelopeGenerator::computeRamp(float a0, float a1, float duration_samples) {
+  curve = ramp;
   switch (ramp) {
     case kEnvelopeRamp_Linear:
       linear_slope = (a1 - a0) / duration_samples;
       break;
     case kEnvelopeRamp_Exponential:
-      exponential_multiplier = 1 + (log(a1) - log(a0)) / duration_samples;
+      exponential_multiplier = 1 + FASTMATH_LN2 * (fastLog2(a1) - fastLog2(a0)) / duration_samples;
       break;
   }
 }
@@ -123,7 +269,8 @@ void EnvelopeGenerator::computeRamp(float a0, float a1, float duration_samples)
 /**
  * Render one sample of the current envelope level. Automatically enter sustain 
  * state from attack if we've reached the maximum level 2^ENV_RES. Automatically 
- * enter idle state from release if we've reached the minimum level.
+ * enter idle state from release if we've reached the minimum level. Breakpoint
+ * segments advance the same way when they reach their targets.
  */
 float EnvelopeGenerator::render() {
   
@@ -131,25 +278,18 @@ float EnvelopeGenerator::render() {
 		case kEnvelopeState_Attack:
       falling_edge = false;
       updateLevel();
-      if (level > sustain_level) {
-        level = sustain_level;
-        if (do_sustain)
-          state = kEnvelopeState_Sustain;
-        else
-          gate(false);
-      }
+      if (passedTarget())
+        endSegment();
 			break;
 		case kEnvelopeState_Release:
       updateLevel();
-      if (level <= EGEN_MIN) {
-        level = EGEN_MIN;
-        state = kEnvelopeState_Idle;
-      }
+      if (passedTarget())
+        endSegment();
       if (level < sustain_level/2 && level_previous > sustain_level/2) 
         falling_edge = true;
 			break;
 		case kEnvelopeState_Sustain:
-      level = sustain_level;
+      level = target;
       break;
 		case kEnvelopeState_Idle:
       level = 0.0;
@@ -160,7 +300,7 @@ float EnvelopeGenerator::render() {
 
 void EnvelopeGenerator::updateLevel() {
   level_previous = level;
-  switch (ramp) {
+  switch (curve) {
     case kEnvelopeRamp_Linear:
       level += linear_slope;
       break;
@@ -170,3 +310,190 @@ void EnvelopeGenerator::updateLevel() {
   }
 }
 
+/**
+ * Block renderer. Splits the block at samples where the gate CV would change the state
+ * (rendered one at a time, as gate_cv() then render()), and renders the spans in between
+ * a segment at a time.
+ */
+void EnvelopeGenerator::renderBlock(float *out, int n, const float *cv) {
+  int i = 0;
+  while (i < n) {
+    int span = cv ? cvQuietSpan(cv + i, n - i) : n - i;
+    if (span == 0) {
+      gate_cv(cv[i]);
+      out[i++] = render();
+    }
+    else
+      i += renderSegment(out + i, span);
+  }
+}
+
+/**
+ * Number of samples (up to n) before gate_cv() would act in the current state. Below the
+ * gate off threshold it restarts an attack/release envelope's release, but leaves a
+ * breakpoint release alone.
+ */
+int EnvelopeGenerator::cvQuietSpan(const float *cv, int n) {
+  if (!cv_gate)
+    return n;
+  if (state == kEnvelopeState_Idle) {
+    for (int i = 0; i < n; i++) {
+      if (cv[i] > gate_on_thresh)
+        return i;
+    }
+  }
+  else if (state == kEnvelopeState_Release && do_sustain && num_segments == 0) {
+    for (int i = 0; i < n; i++) {
+      if (cv[i] < gate_off_thresh)
+        return i;
+    }
+  }
+  return n;
+}
+
+/**
+ * Render up to n samples of the current state, stopping after the sample where the state
+ * or segment changes. Returns the number of samples rendered. Matches render() sample for
+ * sample, including the falling edge flag, which is set when a falling release passes half
+ * the sustain level within the span.
+ */
+int EnvelopeGenerator::renderSegment(float *out, int n) {
+
+  switch (state) {
+
+    case kEnvelopeState_Idle:
+      level = 0.0f;
+      for (int i = 0; i < n; i++)
+        out[i] = 0.0f;
+      return n;
+
+    case kEnvelopeState_Sustain:
+      level = target;
+      for (int i = 0; i < n; i++)
+        out[i] = level;
+      return n;
+
+    case kEnvelopeState_Attack:
+      falling_edge = false;
+      return renderRamp(out, n);
+
+    case kEnvelopeState_Release: {
+      float start = level;
+      float half = sustain_level/2;
+      bool falling = direction < 0;
+      int span = renderRamp(out, n);
+      int edge = span - 1;          // Rises and holds can only drop at the final clamp
+      if (falling)
+        edge = start > half ? firstPast(out, span, rampSteps(start, half), half, false) : span;
+      if (edge < span && out[edge] < half && (edge > 0 ? out[edge - 1] : start) > half)
+        falling_edge = true;
+      return span;
+    }
+  }
+  return n;
+}
+
+/**
+ * Render up to n samples of the current segment's ramp (or hold). The end of the segment
+ * is estimated from the ramp's closed form, the span up to it filled with the same
+ * recurrence render() uses, and the estimate corrected against the filled levels.
+ */
+int EnvelopeGenerator::renderRamp(float *out, int n) {
+
+  float start = level;
+  int span, k;
+
+  if (direction == 0) {
+    span = hold_remaining < n ? hold_remaining : n;
+    fillRamp(out, span);
+    hold_remaining -= span;
+    k = hold_remaining <= 0 ? span - 1 : span;
+  }
+  else if (!rampAdvances(start)) {
+    span = 1;                       // Ends on the first sample, as in render()
+    fillRamp(out, span);
+    k = 0;
+  }
+  else {
+    k = rampSteps(start, target);
+    span = (k < 0 || k >= n) ? n : k + 1;     // One sample of margin for rounding
+    fillRamp(out, span);
+    k = firstPast(out, span, k, target, direction > 0);
+  }
+
+  if (k < span) {
+    span = k + 1;
+    level_previous = k > 0 ? out[k - 1] : start;
+    endSegment();
+    out[k] = level;
+  }
+  return span;
+}
+
+/**
+ * Whether the first step of the current ramp from level 'from' moves toward its target.
+ */
+bool EnvelopeGenerator::rampAdvances(float from) {
+  float next = curve == kEnvelopeRamp_Linear ? from + linear_slope
+                                             : from * exponential_multiplier;
+  return direction > 0 ? next > from : next < from;
+}
+
+/**
+ * Estimated index of the first sample of the current ramp from level 'from' at or past
+ * 'bound', or -1 if the ramp never reaches it.
+ */
+int EnvelopeGenerator::rampSteps(float from, float bound) {
+  float k;
+  if (curve == kEnvelopeRamp_Linear) {
+    if (linear_slope == 0)
+      return -1;
+    k = (bound - from) / linear_slope;
+  }
+  else {
+    if (from <= 0 || bound <= 0 || exponential_multiplier <= 0 || exponential_multiplier == 1)
+      return -1;
+    k = fastLog2(bound / from) / fastLog2(exponential_multiplier);
+  }
+  if (!(k >= 0 && k <= 1e6f))    // Also catches NaN from a degenerate ramp
+    return -1;
+  return (int)k;
+}
+
+/**
+ * Index of the first of n monotonic levels that rises above (rising) or falls to or below
+ * 'bound', searching from an estimate; n if none does.
+ */
+int EnvelopeGenerator::firstPast(const float *out, int n, int guess, float bound, bool rising) {
+  int i = guess < 0 ? n : (guess > n ? n : guess);
+  while (i > 0 && (rising ? out[i - 1] > bound : out[i - 1] <= bound))
+    i--;
+  while (i < n && !(rising ? out[i] > bound : out[i] <= bound))
+    i++;
+  return i;
+}
+
+/**
+ * Fill n samples of the current ramp from the current level and advance the level.
+ */
+void EnvelopeGenerator::fillRamp(float *out, int n) {
+  float v = level;
+  level_previous = v;
+  if (curve == kEnvelopeRamp_Linear) {
+    float slope = linear_slope;
+    for (int i = 0; i < n; i++) {
+      v += slope;
+      out[i] = v;
+    }
+  }
+  else {
+    float m = exponential_multiplier;
+    for (int i = 0; i < n; i++) {
+      v *= m;
+      out[i] = v;
+    }
+  }
+  if (n > 1)
+    level_previous = out[n - 2];
+  level = v;
+}
@@ -2,15 +2,22 @@
  *  
  * Floating-point linear/exponential envelope generator with variable attack and release time.
  * 
+ * Alternatively, a breakpoint shape of up to EGEN_MAX_SEGMENTS segments, each with its own
+ * time, target level and ramp, replaces the attack and release. Segments up to the sustain
+ * point play on gate on and hold at the sustain point's level; the rest play on gate off.
+ * Without a sustain point, the first segment is the attack and the rest the release.
+ * Targets are relative to the sustain level, which sets the shape's amplitude. Each
+ * segment's step is precomputed when the shape is set.
  */
 
 #ifndef ENVELOPGENERATOR_H
 #define ENVELOPGENERATOR_H
 
-#include <Math.h>
+#include <math.h>
 
-#define EGEN_MAX (1.0)
-#define EGEN_MIN (0.001)
+#define EGEN_MAX (1.0f)
+#define EGEN_MIN (0.001f)
+#define EGEN_MAX_SEGMENTS (8)
 
 typedef enum EnvelopeRamp {
   kEnvelopeRamp_Linear = 0,
@@ -24,6 +31,14 @@ typedef enum EnvelopeState {
 	kEnvelopeState_Release
 } EnvelopeState;
 
+typedef struct EnvelopeSegment {
+  float target;         // Level relative to the sustain level
+  float step;           // Linear slope (relative) or exponential multiplier per sample
+  EnvelopeRamp ramp;
+  int direction;        // 1 rising, -1 falling, 0 hold
+  int hold_samples;
+} EnvelopeSegment;
+
 class EnvelopeGenerator {
 
 public:
@@ -38,10 +53,16 @@ public:
   void setSustain(bool doSustain);
   void setGateOnThresh(float thresh); 
   void setGateOffThresh(float thresh);
+  // Breakpoint shape (n = 0 restores attack/release). Sustain point -1 for none.
+  bool setBreakpoints(const float *times_ms, const float *targets, const EnvelopeRamp *ramps,
+                      int n, int sustain_point);
 
   void gate(bool on);
   void gate_cv(float cv);
   float render();
+  // Render n samples, gating with the cv block (if not NULL) as gate_cv() then render()
+  // would per sample. Ramps are filled up to the next transition computed analytically.
+  void renderBlock(float *out, int n, const float *cv);
 
   float getLevel()  { return level; } 
   float getSustain() { return sustain_level; }
@@ -57,6 +78,16 @@ private:
   
   void updateLevel();
   void computeRamp(float a0, float a1, float dur_s);
+  bool passedTarget();
+  void endSegment();
+  void enterSegment(int i);
+  int renderSegment(float *out, int n);
+  int renderRamp(float *out, int n);
+  bool rampAdvances(float from);
+  int rampSteps(float from, float bound);
+  int firstPast(const float *out, int n, int guess, float bound, bool rising);
+  void fillRamp(float *out, int n);
+  int cvQuietSpan(const float *cv, int n);
   
   float atk_time_samples;
   float rel_time_samples;
@@ -67,9 +98,19 @@ private:
   bool do_sustain;      
   EnvelopeState state;
  
-  EnvelopeRamp ramp;
+  EnvelopeRamp ramp;             // Attack/release ramp
+  EnvelopeRamp curve;            // Ramp of the current segment
   float exponential_multiplier;
   float linear_slope;
+  float target;                  // Level ending the current segment
+  int direction;
+  int hold_remaining;
+
+  EnvelopeSegment segments[EGEN_MAX_SEGMENTS];
+  int num_segments;              // 0 for attack/release
+  int sustain_segment;           // Breakpoint index or -1
+  int release_segment;           // First segment played on gate off
+  int segment;                   // Current breakpoint index
   
   float fs;         // Audio sample rate
 
@@ -0,0 +1,104 @@
+#include "FastMath.h"
+#include <Arduino.h>
+#include <math.h>
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+/* === Benchmark === */
+
+// Each kernel is paired with the libm expression it replaced at its call sites, in double
+// precision as they were (hence the explicit casts)
+
+static float fast_mtof(float x)  { return fastMtof(x); }
+static float libm_mtof(float x)  { return pow(2, ((double)x - 69) / 12.0) * 440.0; }
+static float fast_exp2(float x)  { return fastExp2(x); }
+static float libm_exp2(float x)  { return pow(2.0, (double)x); }
+static float fast_log2(float x)  { return fastLog2(x); }
+static float libm_log2(float x)  { return log((double)x) / log(2.0); }
+static float fast_db_to_lin(float x)  { return fastDbToLin(x); }
+static float libm_db_to_lin(float x)  { return pow(10.0, (double)x / 20.0); }
+static float fast_lin_to_db(float x)  { return fastLinToDb(x); }
+static float libm_lin_to_db(float x)  { return 20.0 * log10((double)x); }
+static float fast_one_pole(float x)  { return fastOnePoleCoef(x); }
+static float libm_one_pole(float x)  { return exp(-1 / (double)x); }
+static float fast_sin(float x)  { return fastSin2Pi(x); }
+static float libm_sin(float x)  { return sin(6.28318530717959 * (double)x); }
+
+typedef float (*FastMathFunction)(float x);
+
+typedef struct FastMathBench {
+  const char *name;
+  FastMathFunction fast;
+  FastMathFunction libm;
+  float lo;                   // Argument range
+  float hi;
+  bool relative;              // Relative or absolute error
+} FastMathBench;
+
+static const FastMathBench benches[] = {
+  { "mtof",     fast_mtof,      libm_mtof,      0.0f,   127.0f,   true },
+  { "exp2",     fast_exp2,      libm_exp2,      -16.0f, 16.0f,    true },
+  { "log2",     fast_log2,      libm_log2,      1e-3f,  1e3f,     false },
+  { "db_to_lin", fast_db_to_lin, libm_db_to_lin, -120.0f, 20.0f,  true },
+  { "lin_to_db", fast_lin_to_db, libm_lin_to_db, 1e-6f,  10.0f,   false },
+  { "one_pole", fast_one_pole,  libm_one_pole,  1.0f,   44100.0f, true },
+  { "sin2pi",   fast_sin,       libm_sin,       0.0f,   1.0f,     false }
+};
+
+static volatile float sink;     // Keeps results from being optimized away
+
+/**
+ * Best-of-FASTMATH_BENCH_RUNS cycles per call of f over FASTMATH_BENCH_CALLS arguments
+ * spread over [lo, hi]. Called through a pointer, so both sides include the call.
+ */
+static float cycles_per_call(FastMathFunction f, float lo, float hi) {
+  float step = (hi - lo) / FASTMATH_BENCH_CALLS;
+  uint32_t best = 0xffffffff;
+  for (int r = 0; r < FASTMATH_BENCH_RUNS; r++) {
+    uint32_t start = ARM_DWT_CYCCNT;
+    float x = lo;
+    for (int i = 0; i < FASTMATH_BENCH_CALLS; i++) {
+      sink = f(x);
+      x += step;
+    }
+    uint32_t cycles = ARM_DWT_CYCCNT - start;
+    if (cycles < best)
+      best = cycles;
+  }
+  return best / (float)FASTMATH_BENCH_CALLS;
+}
+
+/**
+ * Time each kernel and the libm expression it replaces with the DWT cycle counter (enabled
+ * by CpuLoadMeter::begin()), and measure the kernel's largest error over the same
+ * arguments. Runs from the main loop with interrupts enabled, so a run that includes an
+ * audio interrupt is discarded by taking the best run. Returns the number of results.
+ */
+int fastMathBenchmark(FastMathBenchResult *results, int max_results) {
+
+  int n = sizeof(benches) / sizeof(benches[0]);
+  if (n > max_results)
+    n = max_results;
+
+  for (int b = 0; b < n; b++) {
+    const FastMathBench &bench = benches[b];
+    FastMathBenchResult &result = results[b];
+    result.name = bench.name;
+    result.fast_cycles = cycles_per_call(bench.fast, bench.lo, bench.hi);
+    result.libm_cycles = cycles_per_call(bench.libm, bench.lo, bench.hi);
+
+    float step = (bench.hi - bench.lo) / FASTMATH_BENCH_CALLS;
+    float max_error = 0.0f;
+    float x = bench.lo;
+    for (int i = 0; i < FASTMATH_BENCH_CALLS; i++) {
+      float ref = bench.libm(x);
+      float err = fabsf(bench.fast(x) - ref);
+      if (bench.relative && ref != 0.0f)
+        err /= fabsf(ref);
+      if (err > max_error)
+        max_error = err;
+      x += step;
+    }
+    result.max_error = max_error;
+  }
+  return n;
+}
@@ -0,0 +1,118 @@
+/* FastMath.h
+ *
+ *  Single-precision replacements for the libm calls made on note and parameter changes
+ *  and in the audio interrupts. libm's pow(), exp(), log() and sin() run in double
+ *  precision in software on the Cortex-M4F; these kernels are inline float polynomials
+ *  on the FPU. Error bounds (measured against double precision libm over the given
+ *  range, including float rounding):
+ *
+ *    fastExp2(x)           2^x, x in [-126, 127]                 relative < 2e-7
+ *    fastLog2(x)           log2(x), x in [2^-16, 2^16]           absolute < 2e-6
+ *    fastExp(x), fastLog(x), fastPow(x, y)    via fastExp2() and fastLog2()
+ *    fastMtof(note)        MIDI note number to Hz, [0, 127]      relative < 1e-6
+ *    fastDbToLin(db)       10^(db/20), db in [-120, 120]         relative < 1e-6
+ *    fastLinToDb(lin)      20 log10(lin), lin in [1e-6, 1e6]     absolute < 2e-5 dB
+ *    fastOnePoleCoef(n)    exp(-1/n), the coefficient of a one-pole smoother with a
+ *                          time constant of n samples, n >= 1    relative < 2e-7
+ *    fastSin2Pi(x)         sin(2 pi x), x in turns               absolute < 3e-7
+ *
+ *  Arguments outside the stated ranges are clipped (exp2) or return meaningless values
+ *  (log2 of x <= 0). fastMathBenchmark() measures each against the libm call it replaces.
+ */
+
+#ifndef FASTMATH_H
+#define FASTMATH_H
+
+#include <stdint.h>
+
+#define FASTMATH_LN2 (0.693147181f)
+#define FASTMATH_LOG2E (1.442695041f)
+#define FASTMATH_LOG2_10_OVER_20 (0.166096405f)   // log2(10)/20
+#define FASTMATH_20_LOG10_2 (6.020599913f)        // 20*log10(2)
+
+typedef union FastMathBits {
+  float f;
+  int32_t i;
+} FastMathBits;
+
+/**
+ * 2^x. Splits x into integer and fraction; the integer part is written to the exponent
+ * and 2^fraction comes from a degree-5 polynomial on [0, 1).
+ */
+static inline float fastExp2(float x) {
+  if (x < -126.0f) x = -126.0f;
+  if (x > 127.0f) x = 127.0f;
+  int i = (int)x;
+  if (x < i) i--;                           // Floor
+  float f = x - i;
+  float p = 9.999998984e-01f + f*(6.931544897e-01f + f*(2.401418182e-01f +
+            f*(5.586033708e-02f + f*(8.949590423e-03f + f*1.893754058e-03f))));
+  FastMathBits scale;
+  scale.i = (i + 127) << 23;
+  return p * scale.f;
+}
+
+/**
+ * log2(x) for x > 0. The exponent is read from the float's bits and log2 of the mantissa
+ * in [1, 2) comes from a degree-7 polynomial that is exact at 1, so powers of two are
+ * exact.
+ */
+static inline float fastLog2(float x) {
+  FastMathBits bits;
+  bits.f = x;
+  int e = ((bits.i >> 23) & 0xff) - 127;
+  bits.i = (bits.i & 0x007fffff) | 0x3f800000;
+  float m = bits.f - 1.0f;
+  float p = m*(1.442647549e+00f + m*(-7.203160644e-01f + m*(4.720869162e-01f +
+            m*(-3.219602855e-01f + m*(1.887527377e-01f + m*(-7.565137468e-02f +
+            m*1.444035249e-02f))))));
+  return e + p;
+}
+
+static inline float fastExp(float x)  { return fastExp2(x * FASTMATH_LOG2E); }
+static inline float fastLog(float x)  { return fastLog2(x) * FASTMATH_LN2; }
+static inline float fastPow(float x, float y)  { return fastExp2(y * fastLog2(x)); }
+
+static inline float fastMtof(float note)  {
+  return 440.0f * fastExp2((note - 69.0f) * (1.0f / 12.0f));
+}
+
+static inline float fastDbToLin(float db)  { return fastExp2(db * FASTMATH_LOG2_10_OVER_20); }
+static inline float fastLinToDb(float lin)  { return fastLog2(lin) * FASTMATH_20_LOG10_2; }
+
+static inline float fastOnePoleCoef(float time_samples)  {
+  return fastExp2(-FASTMATH_LOG2E / time_samples);
+}
+
+/**
+ * sin(2 pi x) for x in turns. Reduced to [-1/4, 1/4] turn by symmetry, then an odd
+ * Taylor polynomial to the 11th power.
+ */
+static inline float fastSin2Pi(float x) {
+  int i = (int)x;
+  if (x < i) i--;
+  x -= i;                                   // [0, 1)
+  if (x > 0.5f) x -= 1.0f;                  // [-1/2, 1/2]
+  if (x > 0.25f) x = 0.5f - x;              // [-1/4, 1/4]
+  else if (x < -0.25f) x = -0.5f - x;
+  float r = x * 6.283185307f;
+  float r2 = r * r;
+  return r * (1.0f + r2*(-1.666666667e-01f + r2*(8.333333333e-03f + r2*(-1.984126984e-04f +
+              r2*(2.755731922e-06f + r2*-2.505210839e-08f)))));
+}
+
+/* Benchmark */
+
+#define FASTMATH_BENCH_CALLS (256)        // Calls per function and run
+#define FASTMATH_BENCH_RUNS (4)           // Best of
+
+typedef struct FastMathBenchResult {
+  const char *name;
+  float fast_cycles;          // Per call
+  float libm_cycles;          // Per call of the libm expression it replaces
+  float max_error;            // Relative or absolute, as bounded above
+} FastMathBenchResult;
+
+int fastMathBenchmark(FastMathBenchResult *results, int max_results);
+
+#endif
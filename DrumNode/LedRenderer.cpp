@@ -0,0 +1,127 @@
+#include "LedRenderer.h"
+#include <Arduino.h>
+#include <math.h>
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+LedRenderer::LedRenderer(float sample_rate, float rate_hz) :
+  gamma(LED_DEFAULT_GAMMA), brightness(1.0f), table_dirty(false), note_boost(1.0f),
+  tick_count(0), ready(false), follower_level(0.0f), lfo_level(0.0f), egen_level(0.0f),
+  gated(false) {
+
+  tick_period = sample_rate / rate_hz + 0.5f;
+  if (tick_period < 1)
+    tick_period = 1;
+
+  for (int i = 0; i < kLedNumChannels; i++) {
+    pins[i] = -1;
+    written[i] = -1;
+  }
+
+  setGatedColor(1.0f, 1.0f, 1.0f);
+  setNoteColor(1.0f, 0.5f, 0.25f);
+  buildTable();
+}
+
+LedRenderer::~LedRenderer() { }
+
+void LedRenderer::setPin(LedChannel ch, int pin) {
+  pins[ch] = pin;
+  written[ch] = -1;
+}
+
+/**
+ * Gamma and brightness changes only mark the table; it is rebuilt by update() so the
+ * powf() calls stay out of interrupt context.
+ */
+void LedRenderer::setGamma(float g) {
+  gamma = g > 0.0f ? g : 1.0f;
+  table_dirty = true;
+}
+
+void LedRenderer::setBrightness(float b) {
+  brightness = b < 0.0f ? 0.0f : (b > 1.0f ? 1.0f : b);
+  table_dirty = true;
+}
+
+void LedRenderer::setGatedColor(float r, float g, float b) {
+  gated_color[0] = r;
+  gated_color[1] = g;
+  gated_color[2] = b;
+}
+
+void LedRenderer::setNoteColor(float r, float g, float b) {
+  note_color[0] = r;
+  note_color[1] = g;
+  note_color[2] = b;
+}
+
+void LedRenderer::setNoteBoost(float boost) {
+  note_boost = boost;
+}
+
+/**
+ * Called once per audio sample. Only counts until the next refresh, then copies the
+ * levels for update().
+ */
+void LedRenderer::tick(float follower, float lfo, float egen, bool cv_gated) {
+  if (++tick_count < tick_period)
+    return;
+  tick_count = 0;
+  follower_level = follower;
+  lfo_level = 0.5f * (lfo + 1.0f);
+  egen_level = egen;
+  gated = cv_gated;
+  ready = true;
+}
+
+void LedRenderer::update() {
+
+  if (table_dirty) {
+    table_dirty = false;
+    buildTable();
+    for (int i = 0; i < kLedNumChannels; i++)
+      written[i] = -1;
+  }
+
+  if (!ready)
+    return;
+
+  noInterrupts();
+  float levels[kLedNumChannels];
+  levels[kLedFollower] = follower_level;
+  levels[kLedLfo] = lfo_level;
+  levels[kLedEgen] = egen_level;
+  bool cv_gated = gated;
+  ready = false;
+  interrupts();
+
+  // LED bulb
+  const float *color = cv_gated ? gated_color : note_color;
+  float scale = cv_gated ? 1.0f : note_boost;
+  for (int c = 0; c < 3; c++)
+    levels[kLedRed + c] = levels[kLedEgen] * color[c] * scale;
+
+  for (int i = 0; i < kLedNumChannels; i++) {
+    if (pins[i] < 0)
+      continue;
+    uint16_t value = lookup(levels[i]);
+    if (value != written[i]) {
+      analogWrite(pins[i], value);
+      written[i] = value;
+    }
+  }
+}
+
+void LedRenderer::buildTable() {
+  float scale = brightness * LED_PWM_MAX;
+  for (int i = 0; i < LED_TABLE_LEN; i++)
+    table[i] = powf(i / (float)(LED_TABLE_LEN - 1), gamma) * scale + 0.5f;
+}
+
+uint16_t LedRenderer::lookup(float level) {
+  if (level <= 0.0f)
+    return table[0];
+  if (level >= 1.0f)
+    return table[LED_TABLE_LEN - 1];
+  return table[(int)(level * (LED_TABLE_LEN - 1) + 0.5f)];
+}
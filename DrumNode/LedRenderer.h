@@ -0,0 +1,78 @@
+/* LedRenderer.h
+ *
+ *  Control-rate LED output. The audio interrupt calls tick() every sample, which latches
+ *  the follower/LFO/EGEN levels at a fixed refresh rate; the main loop calls update() to
+ *  map the latest snapshot through a gamma/brightness lookup table and write only the
+ *  PWM channels whose values changed. The bulb color for CV-gated and note/OSC-gated
+ *  envelopes is configurable.
+ */
+
+#ifndef LEDRENDERER_H
+#define LEDRENDERER_H
+
+#include <stdint.h>
+
+#define LED_TABLE_LEN (256)         // Levels quantized to 8 bits before the lookup
+#define LED_PWM_MAX (1023)          // Full-scale duty at the 12-bit analogWrite resolution
+#define LED_DEFAULT_GAMMA (2.2f)
+#define LED_DEFAULT_RATE_HZ (100.0f)
+
+typedef enum LedChannel {
+  kLedFollower = 0,
+  kLedLfo,
+  kLedEgen,
+  kLedRed,
+  kLedGreen,
+  kLedBlue,
+  kLedNumChannels
+} LedChannel;
+
+class LedRenderer {
+
+public:
+
+  LedRenderer(float sample_rate, float rate_hz);
+  ~LedRenderer();
+
+  void setPin(LedChannel ch, int pin);
+
+  // Parameter i/o
+  void setGamma(float gamma);
+  void setBrightness(float brightness);       // [0.0, 1.0]
+  void setGatedColor(float r, float g, float b);
+  void setNoteColor(float r, float g, float b);
+  void setNoteBoost(float boost);             // Scales the note color (VCA LFO compensation)
+
+  // Audio interrupt: latch levels at the refresh rate
+  void tick(float follower, float lfo, float egen, bool cv_gated);
+
+  // Main loop: write changed PWM values if a new snapshot is ready
+  void update();
+
+private:
+
+  void buildTable();
+  uint16_t lookup(float level);
+
+  int pins[kLedNumChannels];
+  int16_t written[kLedNumChannels];     // Last value written per channel (-1 forces a write)
+
+  uint16_t table[LED_TABLE_LEN];        // Level --> PWM duty
+  float gamma;
+  float brightness;
+  volatile bool table_dirty;
+
+  float gated_color[3];
+  float note_color[3];
+  float note_boost;
+
+  int tick_period;                      // Audio samples per refresh
+  int tick_count;
+  volatile bool ready;
+  float follower_level;                 // Snapshot taken by tick()
+  float lfo_level;
+  float egen_level;
+  bool gated;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#include "ModMatrix.h"
+#include <Arduino.h>
+#include <string.h>
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+static const char *source_names[kModNumSources] = {
+  "lfo", "egen1", "egen2", "follower", "cv1", "cv2", "cv3"
+};
+
+static const char *dest_names[kModNumDests] = {
+  "vco1", "vco2", "lfo", "vca1", "vca2", "fb_gain", "delay", "gate_thresh"
+};
+
+ModMatrix::ModMatrix() : num_routes(0) {
+  for (int i = 0; i < kModNumSources; i++)
+    sources[i] = 0.0f;
+  for (int i = 0; i < kModNumDests; i++) {
+    sums[i] = 0.0f;
+    applied[i] = 0.0f;
+    stale[i] = true;
+    apply[i] = NULL;
+  }
+}
+
+ModMatrix::~ModMatrix() { }
+
+void ModMatrix::setDestination(ModDest dst, ModApplyFunction fn) {
+  apply[dst] = fn;
+  stale[dst] = true;
+}
+
+/**
+ * Update the amount of an existing route in place, or append a new one. Removing a route
+ * moves the last route into its slot with interrupts disabled, so evaluate() never sees a
+ * route twice.
+ */
+bool ModMatrix::setRoute(ModSource src, ModDest dst, float amount) {
+
+  int i;
+  for (i = 0; i < num_routes; i++) {
+    if (routes[i].src == src && routes[i].dst == dst)
+      break;
+  }
+
+  if (amount == 0.0f) {
+    if (i < num_routes) {
+      noInterrupts();
+      routes[i] = routes[num_routes - 1];
+      num_routes--;
+      interrupts();
+    }
+    return true;
+  }
+
+  if (i < num_routes) {
+    routes[i].amount = amount;
+    return true;
+  }
+  if (num_routes == MOD_MAX_ROUTES)
+    return false;
+  routes[i].src = src;
+  routes[i].dst = dst;
+  routes[i].amount = amount;
+  __sync_synchronize();         // Route complete before it's counted
+  num_routes++;
+  return true;
+}
+
+void ModMatrix::clear() {
+  num_routes = 0;
+}
+
+void ModMatrix::evaluate() {
+  for (int d = 0; d < kModNumDests; d++)
+    sums[d] = 0.0f;
+  int n = num_routes;
+  for (int i = 0; i < n; i++)
+    sums[routes[i].dst] += routes[i].amount * sources[routes[i].src];
+  for (int d = 0; d < kModNumDests; d++) {
+    if (apply[d] && (sums[d] != applied[d] || stale[d])) {
+      stale[d] = false;
+      applied[d] = sums[d];
+      apply[d](sums[d]);
+    }
+  }
+}
+
+int ModMatrix::findSource(const char *name) {
+  for (int i = 0; i < kModNumSources; i++) {
+    if (strcmp(name, source_names[i]) == 0)
+      return i;
+  }
+  return -1;
+}
+
+int ModMatrix::findDest(const char *name) {
+  for (int i = 0; i < kModNumDests; i++) {
+    if (strcmp(name, dest_names[i]) == 0)
+      return i;
+  }
+  return -1;
+}
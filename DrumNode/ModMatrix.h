@@ -0,0 +1,89 @@
+/* ModMatrix.h
+ *
+ *  Sparse modulation matrix. Routes (source, destination, amount) are kept in a compact
+ *  list; evaluate() sums amount * source for each destination once per control block and
+ *  passes a destination's sum to the function registered for it when the sum changes, so
+ *  a destination whose last route was removed is reset to zero modulation. refresh()
+ *  re-applies a destination whose function combines the sum with a base value that
+ *  changed.
+ *
+ *  Sources are written with setSource() before each evaluate(). Routes are edited from
+ *  the main loop and evaluated from the audio interrupt.
+ */
+
+#ifndef MODMATRIX_H
+#define MODMATRIX_H
+
+#include <stdint.h>
+
+#define MOD_MAX_ROUTES (16)
+
+typedef enum ModSource {
+  kModSrcLfo = 0,       // [-1, 1]
+  kModSrcEgen1,         // [0, 1]
+  kModSrcEgen2,
+  kModSrcFollower,
+  kModSrcCv1,           // [0, 1]
+  kModSrcCv2,
+  kModSrcCv3,
+  kModNumSources
+} ModSource;
+
+typedef enum ModDest {
+  kModDstVco1Pitch = 0, // Octaves
+  kModDstVco2Pitch,
+  kModDstLfoPitch,
+  kModDstVca1Gain,      // Output gain offset (gain = 1 + mod, clipped to [0, 1])
+  kModDstVca2Gain,
+  kModDstFbGain,        // Offset added to the feedback input gain
+  kModDstDelay,         // Samples added to the feedback delay
+  kModDstGateThresh,    // Offset added to the follower gate thresholds
+  kModNumDests
+} ModDest;
+
+typedef void (*ModApplyFunction)(float value);
+
+class ModMatrix {
+
+public:
+
+  ModMatrix();
+  ~ModMatrix();
+
+  void setDestination(ModDest dst, ModApplyFunction fn);
+
+  // Routes (main loop). An amount of zero removes the route.
+  bool setRoute(ModSource src, ModDest dst, float amount);
+  void clear();
+  int count()  { return num_routes; }
+
+  // Re-apply a destination at the next evaluate() (main loop)
+  void refresh(ModDest dst)  { stale[dst] = true; }
+
+  // Control block (audio interrupt)
+  void setSource(ModSource src, float value)  { sources[src] = value; }
+  void evaluate();
+
+  // Names used by OSC messages, or -1 if unknown
+  static int findSource(const char *name);
+  static int findDest(const char *name);
+
+private:
+
+  typedef struct ModRoute {
+    uint8_t src;
+    uint8_t dst;
+    float amount;
+  } ModRoute;
+
+  ModRoute routes[MOD_MAX_ROUTES];
+  volatile int num_routes;
+
+  float sources[kModNumSources];
+  float sums[kModNumDests];
+  float applied[kModNumDests];          // Sum last passed to each destination
+  volatile bool stale[kModNumDests];    // Apply at the next evaluate() regardless
+  ModApplyFunction apply[kModNumDests];
+};
+
+#endif
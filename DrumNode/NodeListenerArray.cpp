@@ -1,4 +1,6 @@
 #include "NodeListenerArray.h"
+#include "DebugLog.h"
+#pragma GCC diagnostic error "-Wdouble-promotion"
 
 NodeListenerArray::NodeListenerArray() {}
 
@@ -105,20 +107,13 @@ int NodeListenerArray::match_listener(IPAddress ip, int port) {
 }
 
 /**
- * Print IP addresses and port numbers of any OSC listeners.
+ * Log IP addresses and port numbers of any OSC listeners.
  */
 void NodeListenerArray::print_listeners() {
-  Serial.println();
-  Serial.print(osc_listeners.size());
-  Serial.println(" OSC listeners");
+  debug_log.log("%d OSC listeners", (int)osc_listeners.size());
   for (int i = 0; i < osc_listeners.size(); i++) {
-    Serial.print("OSC Listener ");
-    Serial.print(i);
-    Serial.println(":");
-    Serial.print("  IP: ");
-    Serial.println(osc_listeners[i].ip);
-    Serial.print("PORT: ");
-    Serial.println(osc_listeners[i].port);
+    IPAddress &ip = osc_listeners[i].ip;
+    debug_log.log("OSC Listener %d: %d.%d.%d.%d [%d]", i, ip[0], ip[1], ip[2], ip[3],
+                  osc_listeners[i].port);
   }
 }
-
@@ -0,0 +1,42 @@
+#include "OscPacketQueue.h"
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+OscPacketQueue::OscPacketQueue() :
+  head(0), tail(0), write_size(0), overflow(false), dropped(0) { }
+
+OscPacketQueue::~OscPacketQueue() { }
+
+/**
+ * Bytes are written straight into the slot at head. If the ring is full the packet is
+ * still consumed from the serial port but discarded at endPacket().
+ */
+void OscPacketQueue::write(uint8_t byte) {
+  if (head - tail == OSC_QUEUE_SLOTS || write_size == OSC_PACKET_MAX_BYTES) {
+    overflow = true;
+    return;
+  }
+  slots[head & (OSC_QUEUE_SLOTS-1)].data[write_size++] = byte;
+}
+
+void OscPacketQueue::endPacket() {
+  if (overflow)
+    dropped++;
+  else if (write_size > 0) {
+    slots[head & (OSC_QUEUE_SLOTS-1)].size = write_size;
+    __sync_synchronize();             // Packet contents visible before the new head
+    head++;
+  }
+  write_size = 0;
+  overflow = false;
+}
+
+uint8_t *OscPacketQueue::front(int &size) {
+  Packet &p = slots[tail & (OSC_QUEUE_SLOTS-1)];
+  size = p.size;
+  return p.data;
+}
+
+void OscPacketQueue::pop() {
+  __sync_synchronize();               // Finish reading the slot before releasing it
+  tail++;
+}
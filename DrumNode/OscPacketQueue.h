@@ -0,0 +1,49 @@
+/* OscPacketQueue.h
+ *
+ *  Bounded ring of raw (SLIP-decoded) OSC packets. The SLIP serial interrupt appends bytes
+ *  and commits a packet at each SLIP end marker; the main loop parses and dispatches a
+ *  bounded number of packets per pass. Single producer (interrupt), single consumer (loop).
+ */
+
+#ifndef OSCPACKETQUEUE_H
+#define OSCPACKETQUEUE_H
+
+#include <stdint.h>
+
+#define OSC_QUEUE_SLOTS (8)             // Must be power of 2
+#define OSC_PACKET_MAX_BYTES (256)
+
+class OscPacketQueue {
+
+public:
+
+  OscPacketQueue();
+  ~OscPacketQueue();
+
+  // Producer (interrupt)
+  void write(uint8_t byte);           // Append a byte to the packet being received
+  void endPacket();                   // Commit the packet, or drop it if it overflowed
+
+  // Consumer (main loop)
+  bool available()  { return tail != head; }
+  uint8_t *front(int &size);          // Oldest committed packet
+  void pop();
+
+  uint32_t droppedCount()  { return dropped; }
+
+private:
+
+  typedef struct Packet {
+    uint8_t data[OSC_PACKET_MAX_BYTES];
+    int size;
+  } Packet;
+
+  Packet slots[OSC_QUEUE_SLOTS];
+  volatile uint32_t head;             // Next slot to commit (written by producer)
+  volatile uint32_t tail;             // Oldest committed slot (written by consumer)
+  int write_size;                     // Bytes received for the packet at head
+  bool overflow;
+  volatile uint32_t dropped;
+};
+
+#endif
@@ -1,14 +1,51 @@
 #include "Oscillator.h"
+#include "OscillatorCore.h"
+#include "FastMath.h"
 #include <math.h>
+#pragma GCC diagnostic error "-Wdouble-promotion"
 
-Oscillator::Oscillator(float sample_rate, float f0) : 
-  fs(sample_rate), f0_mod(0.0), f0_mod_amp(0.0), waveShape(kWaveShapeSine) {
+float WaveTables::sine[TAB_LEN];
+float WaveTables::square[mipStorage(0)];
+float WaveTables::saw[mipStorage(0)];
+const float *volatile WaveTables::user = WaveTables::sine;
+int WaveTables::mip_offset[MIP_LEVELS];
+int WaveTables::mip_shift[MIP_LEVELS];
+float Oscillator::pitchtable[PITCH_TAB_LEN];
+bool Oscillator::tables_initialized = false;
+
+// Render loops by [WaveShape][OscInterpolation]
+static const OscRenderFunction render_functions[4][3] = {
+  { OscillatorCore<SineWave, InterpNone>::render,
+    OscillatorCore<SineWave, InterpLinear>::render,
+    OscillatorCore<SineWave, InterpCubic>::render },
+  { OscillatorCore<SquareWave, InterpNone>::render,
+    OscillatorCore<SquareWave, InterpLinear>::render,
+    OscillatorCore<SquareWave, InterpCubic>::render },
+  { OscillatorCore<SawWave, InterpNone>::render,
+    OscillatorCore<SawWave, InterpLinear>::render,
+    OscillatorCore<SawWave, InterpCubic>::render },
+  { OscillatorCore<UserWave, InterpNone>::render,
+    OscillatorCore<UserWave, InterpLinear>::render,
+    OscillatorCore<UserWave, InterpCubic>::render }
+};
+
+static const OscRenderFunction morph_functions[3] = {
+  OscillatorMorph<InterpNone>::render,
+  OscillatorMorph<InterpLinear>::render,
+  OscillatorMorph<InterpCubic>::render
+};
+
+Oscillator::Oscillator(float sample_rate, float f0, OscInterpolation interp) : 
+  fs(sample_rate), pitch_ratio(1.0), waveShape(kWaveShapeSine), interpolation(interp),
+  glide_time_ms(0.0), glide_mode(kGlideLinear), control_block(1), glide_blocks(0),
+  select() {
   
-  table_init();           // Initialize sine wave table
+  table_init();           // Initialize wave tables (once, shared)
+  selectRender();
   setF0(f0);              // Set fundamental frequency in Hz
 
   accumulator = 0;        // Initialize 32-bit phase accumulator
-  value = sintable[0];    // Initialize first wavetable value
+  value = WaveTables::sine[0];    // Initialize first wavetable value
 }
 
 Oscillator::~Oscillator() { }
@@ -17,80 +54,216 @@ Oscillator::~Oscillator() { }
  *  Set the oscillator's frequency in Hz. 
  */
 void Oscillator::setF0(float f0_Hz) {
-  f0_base = f0_Hz;
-  f0 = f0_base + f0_base*f0_mod_amp*f0_mod;
-  setF0Norm(f0 / fs);
+
+  float target = f0_Hz / fs;
+  int blocks = glide_time_ms * 0.001f * fs / control_block + 0.5f;
+  // An exponential glide from 0 Hz (the first note, or after a 0 Hz set) has no pitch to
+  // start from, so it jumps to the target
+  if (blocks < 1 || f0_Hz <= 0 || (glide_mode == kGlideExponential && f0_base_norm <= 0)) {
+    glide_blocks = 0;
+    f0_base_norm = target;
+    setF0Norm(f0_base_norm * pitch_ratio);
+    return;
+  }
+
+  // Per-block increment for the whole glide, so updateGlide() only adds or multiplies
+  glide_blocks = 0;                     // Stop any glide in progress while updating
+  glide_target = target;
+  if (glide_mode == kGlideExponential)
+    glide_step = fastExp2(fastLog2(target / f0_base_norm) / blocks);
+  else
+    glide_step = (target - f0_base_norm) / blocks;
+  glide_blocks = blocks;
 }
 
-void Oscillator::setF0Mod(float mod) {
-  f0_mod = mod;
-  f0 = f0_base + f0_base*f0_mod_amp*f0_mod;
-  setF0Norm(f0 / fs);
+/**
+ * Set the portamento time (zero disables) and whether the frequency moves linearly in Hz
+ * or in pitch. Applies from the next call to setF0().
+ */
+void Oscillator::setGlide(float time_ms, GlideMode mode) {
+  glide_time_ms = time_ms > 0 ? time_ms : 0;
+  glide_mode = mode;
+}
+
+void Oscillator::setControlBlock(int samples) {
+  control_block = samples > 0 ? samples : 1;
 }
 
-void Oscillator::setF0ModAmp(float amp) {
-  f0_mod_amp = amp;
-  f0 = f0_base + f0_base*f0_mod_amp*f0_mod;
-  setF0Norm(f0 / fs);
+/**
+ * Advance a glide in progress by one control block.
+ */
+void Oscillator::updateGlide() {
+  if (glide_blocks == 0)
+    return;
+  if (--glide_blocks == 0)
+    f0_base_norm = glide_target;        // Land exactly on the target
+  else if (glide_mode == kGlideExponential)
+    f0_base_norm *= glide_step;
+  else
+    f0_base_norm += glide_step;
+  setF0Norm(f0_base_norm * pitch_ratio);
 }
 
+/**
+ * Offset the frequency from the base by a number of octaves (clipped to +/- 
+ * PITCH_MOD_OCTAVES). The ratio is interpolated from a table of powers of two, so 
+ * modulation at control rate costs no divisions or calls to pow().
+ */
+void Oscillator::setPitchMod(float octaves) {
+  float x = (octaves + PITCH_MOD_OCTAVES) * PITCH_TAB_STEPS;
+  if (x <= 0)
+    pitch_ratio = pitchtable[0];
+  else if (x >= PITCH_TAB_LEN - 1)
+    pitch_ratio = pitchtable[PITCH_TAB_LEN - 1];
+  else {
+    int idx = x;
+    float frac = x - idx;
+    pitch_ratio = pitchtable[idx] + frac * (pitchtable[idx + 1] - pitchtable[idx]);
+  }
+  setF0Norm(f0_base_norm * pitch_ratio);
+}
+
+/**
+ * Wave shape and interpolation swap the render loop; a block in progress finishes with
+ * the previous one.
+ */
 void Oscillator::setWaveShape(WaveShape shape) {
   waveShape = shape;
+  selectRender();
+}
+
+/**
+ * Morph across sine (0), square (1), saw (2) and the user table (3), crossfading between
+ * the two shapes either side of the position.
+ */
+void Oscillator::setMorph(float position) {
+  if (position < 0) position = 0;
+  if (position > OSC_MORPH_MAX) position = OSC_MORPH_MAX;
+  select.morph = position;
+  waveShape = kWaveShapeMorph;
+  selectRender();
+}
+
+void Oscillator::setInterpolation(OscInterpolation interp) {
+  interpolation = interp;
+  selectRender();
+}
+
+/**
+ * Point every oscillator's user shape at a new table. Call between render calls (the
+ * audio interrupt's control block), so no block reads from two tables.
+ */
+void Oscillator::setUserTable(const float *table) {
+  WaveTables::user = table;
+}
+
+void Oscillator::selectRender() {
+  int interp = interpolation <= kInterpCubic ? interpolation : kInterpNone;
+  if (waveShape == kWaveShapeMorph) {
+    render_fn = morph_functions[interp];
+    return;
+  }
+  int shape = waveShape <= kWaveShapeUser ? waveShape : kWaveShapeSine;
+  render_fn = render_functions[shape][interp];    // Single store, safe from the main loop
 }
 
 /**
  * Set the oscillator's frequency (normalized), where [0, 0.5) corresponds to [0, f_nyquist). 
  * Phase represents a fraction of the maximum value representable by uint32_t, which is the  
  * combination of B integer and F fractional indices. 
+ *
+ * Also picks the band-limited mip level. Level k's top harmonic stays below Nyquist while 
+ * x = log2(2 * f0 * MIP_TOP_HARMONICS) <= k, so over the octave (k - 1, k] level k is 
+ * crossfaded into level k + 1, which drops the top octave of harmonics before it folds.
  */
 void Oscillator::setF0Norm(float f0) {
-  phase = target_phase = f0 * 4294967296. + 0.5;  // 2^32 = 4294967296
-  phase_slope = 0;
-}
+  phase = f0 * 4294967296.0f + 0.5f;   // 2^32 = 4294967296
 
-void Oscillator::setF0Norm(float f0, float rise_time_ms) {
-  target_phase = f0 * 4294967296. + 0.5;          // 2^32 = 4294967296
-  phase_slope = (target_phase - phase) / (rise_time_ms / 1000.0 * fs);
+  int level = 0;
+  float mix = 0.0f;
+  if (f0 > 0) {
+    float x = fastLog2(f0 * (2 * MIP_TOP_HARMONICS));
+    level = (int)x;
+    if (level < x) level++;             // Ceiling
+    mix = x - (level - 1);
+    if (level <= 0) {
+      level = 0;
+      mix = 0.0f;
+    }
+    else if (level >= MIP_LEVELS - 1) {
+      level = MIP_LEVELS - 1;
+      mix = 0.0f;
+    }
+  }
+  select.mip_level = level;
+  select.mip_mix = mix;
 }
 
 /** 
  *  Render and return one oscillator sample.
  */
 float Oscillator::render() {
-  
-  int idx = (accumulator >> IDX_FRAC_RES) & (TAB_LEN-1);  // Remove fractional part of index
-
-  switch (waveShape) {
-    case kWaveShapeSquare:
-      value = squaretable[idx];
-      break;
-    case kWaveShapeSaw:
-      value = sawtable[idx];
-      break;
-    case kWaveShapeSine:
-    default:
-      value = sintable[idx];
-      break;  
-  }                   
-
-  // Update the phase if we're ramping to a target fundamental frequency
-  if ((phase_slope > 0 && phase < target_phase) || (phase_slope < 0 && phase > target_phase))
-    phase += phase_slope;
-    
-  accumulator += phase;     // Increment the phase, exploit 32-bit overflow to wrap back to zero
-  return value;
+  return render_fn(&value, 1, &accumulator, phase, select);
+}
+
+/**
+ *  Render n >= 1 samples into out. The render loop is read once for the whole block.
+ */
+void Oscillator::renderBlock(float *out, int n) {
+  value = render_fn(out, n, &accumulator, phase, select);
 }
 
 /** 
  *  Pre-computer single period wavetables.
  */
 void Oscillator::table_init() {
-  float two_pi = 6.28318530717959;
-  for (int i = 0; i < TAB_LEN; ++i) {
-    sintable[i] = sin(two_pi * i / TAB_LEN);
-    squaretable[i] = sintable[i] < 0 ? -1.0 : 1.0;
-    sawtable[i] = 2*i / (float)TAB_LEN - 1;
+  if (tables_initialized)
+    return;
+  for (int i = 0; i < TAB_LEN; ++i)
+    WaveTables::sine[i] = fastSin2Pi(i / (float)TAB_LEN);
+  int offset = 0;
+  for (int k = 0; k < MIP_LEVELS; k++) {
+    int len = mipLength(k);
+    WaveTables::mip_offset[k] = offset;
+    int shift = 32;
+    for (int n = len; n > 1; n >>= 1)
+      shift--;
+    WaveTables::mip_shift[k] = shift;
+    mip_init(WaveTables::square + offset, len, MIP_TOP_HARMONICS >> k, 2);
+    mip_init(WaveTables::saw + offset, len, MIP_TOP_HARMONICS >> k, 1);
+    offset += len;
+  }
+  for (int i = 0; i < PITCH_TAB_LEN; ++i)
+    pitchtable[i] = fastExp2((i - PITCH_MOD_OCTAVES * PITCH_TAB_STEPS) / (float)PITCH_TAB_STEPS);
+  tables_initialized = true;
+}
+
+/**
+ *  Sum the harmonics 1, 1 + step, ... up to num_harmonics of a square (step 2, odd 
+ *  harmonics) or rising saw (step 1) wave into a table of len entries, each at 1/h, read 
+ *  from the sine table. Lanczos sigma factors tame the ringing at the edges, and the table 
+ *  is normalized to a peak of 1.
+ */
+void Oscillator::mip_init(float *table, int len, int num_harmonics, int step) {
+  int stride = TAB_LEN / len;
+  for (int i = 0; i < len; ++i)
+    table[i] = 0.0f;
+  for (int h = 1; h <= num_harmonics; h += step) {
+    float t = h / (float)(num_harmonics + 1);
+    float sigma = fastSin2Pi(0.5f * t) / (3.141592654f * t);
+    float amp = sigma / h;
+    if (step == 1)
+      amp = -amp;                       // Saw rises through zero at half a period
+    for (int i = 0; i < len; ++i)
+      table[i] += amp * WaveTables::sine[(h * i * stride) & (TAB_LEN - 1)];
+  }
+  float peak = 0.0f;
+  for (int i = 0; i < len; ++i) {
+    if (fabsf(table[i]) > peak)
+      peak = fabsf(table[i]);
   }
+  for (int i = 0; i < len; ++i)
+    table[i] /= peak;
 }
 
 
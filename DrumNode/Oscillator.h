@@ -1,7 +1,9 @@
 /* Oscillator.h
  *  
  *  Wavetable oscillator with floating point output and 32-bit freq resolution. 
- *  Implements fractional indexing in Q11.21 fixed point.
+ *  Implements fractional indexing in Q11.21 fixed point. The render loop for each wave
+ *  shape and interpolation is specialized at compile time (OscillatorCore.h) and selected
+ *  through a function pointer, read once per render call.
  */
 
 #ifndef OSCILLATOR_H
@@ -11,53 +13,96 @@
 
 #define TAB_LEN 2048      // Must be power of 2
 #define IDX_FRAC_RES 21   // Must be (32 - log2(TAB_LEN))
+#define PITCH_MOD_OCTAVES 4     // Pitch modulation range (+/- octaves)
+#define PITCH_TAB_STEPS 64      // Pitch table entries per octave
+#define PITCH_TAB_LEN (2*PITCH_MOD_OCTAVES*PITCH_TAB_STEPS + 1)
+#define MIP_LEVELS 10           // Band-limited square/saw levels, one per octave
+#define MIP_TOP_HARMONICS 512   // Harmonics in level 0; halved per level (1 in the last)
+#define MIP_MIN_LEN 256         // Shortest level table (power of 2)
 
 typedef enum WaveShape {
   kWaveShapeSine = 0,
   kWaveShapeSquare,
-  kWaveShapeSaw
+  kWaveShapeSaw,
+  kWaveShapeUser,       // Uploaded table (see WaveTableUpload), shared by all oscillators
+  kWaveShapeMorph       // Crossfade between adjacent shapes above, set by setMorph()
 } WaveShape;
 
+#define OSC_MORPH_MAX ((float)kWaveShapeUser)   // Morph positions [0, 3]
+
+typedef enum OscInterpolation {
+  kInterpNone = 0,      // Truncate the phase to a table entry
+  kInterpLinear,
+  kInterpCubic
+} OscInterpolation;
+
+// Tables read by the render loop, chosen by frequency and morph position
+typedef struct OscTableSelect {
+  int mip_level;        // Band-limited level for the current frequency
+  float mip_mix;        // Crossfade into the next level [0, 1]
+  float morph;          // Position across sine, square, saw and user [0, OSC_MORPH_MAX]
+} OscTableSelect;
+
+// Renders n samples and returns the last; see OscillatorCore
+typedef float (*OscRenderFunction)(float *out, int n, uint32_t *accumulator, uint32_t phase,
+                                   const OscTableSelect &select);
+
+typedef enum GlideMode {
+  kGlideLinear = 0,     // Constant rate in Hz
+  kGlideExponential     // Constant rate in octaves
+} GlideMode;
+
 class Oscillator {
 
 public:
   
-  Oscillator(float sample_rate, float freq_hz);
+  Oscillator(float sample_rate, float freq_hz, OscInterpolation interp = kInterpNone);
   ~Oscillator();
 
   // Parameter i/o
-  void setF0(float f0_Hz);
-  void setF0Mod(float mod);
-  void setF0ModAmp(float amp);
+  void setF0(float f0_Hz);           // Glides to the new frequency if glide time > 0
+  void setPitchMod(float octaves);    // Exponential offset from the base frequency
+  void setGlide(float time_ms, GlideMode mode);
+  void setControlBlock(int samples);  // Samples between updateGlide() calls
 
   void setWaveShape(WaveShape shape);
+  void setMorph(float position);      // Also selects kWaveShapeMorph
+  void setInterpolation(OscInterpolation interp);
+  static void setUserTable(const float *table);     // TAB_LEN samples; block boundary only
 
   // Audio/Control i/o
   float render();
+  void renderBlock(float *out, int n);
+  void updateGlide();                 // Once per control block
   float value;
 
 private:
 
   void table_init(); 
+  static void mip_init(float *table, int len, int num_harmonics, int step);
   void setF0Norm(float freq);
-  void setF0Norm(float f0, float rise_time_ms);
+  void selectRender();
 
-  float sintable[TAB_LEN];      // Wave table (sine)
-  float squaretable[TAB_LEN];   // " " (square)
-  float sawtable[TAB_LEN];      // " " (sawtooth)
+  static float pitchtable[PITCH_TAB_LEN];   // 2^octaves over the modulation range
+  static bool tables_initialized;
 
   WaveShape waveShape;          // Current wave shape
+  OscInterpolation interpolation;
+  volatile OscRenderFunction render_fn;     // Specialized for both
+
+  float f0_base_norm;   // Normalized base frequency
+  float pitch_ratio;    // Pitch modulation frequency ratio
 
-  float f0;             // Fundamental freq. value (base + modulation)
-  float f0_base;        // " " base value
-  float f0_mod;         // " " modulation value
-  float f0_mod_amp;     // " " modulation amplitude
+  float glide_time_ms;
+  GlideMode glide_mode;
+  int control_block;            // Audio samples per control block
+  float glide_target;           // Normalized base frequency at the end of the glide
+  float glide_step;             // Added (linear) or multiplied (exponential) per block
+  volatile int glide_blocks;    // Control blocks left in the glide
 
   uint32_t accumulator;         // 32-bit phase accumulator, where B+F = 32
   int phase;                    // Phase accumulator increment
-  int target_phase;             // Target phase increment (for gliss)
-  int phase_slope;              // Slope to reach target phase (per sample)
-  int rise_time_samples;        // Gliss time in audio samples
+  OscTableSelect select;
 
   float fs;         // Audio sample rate
 };
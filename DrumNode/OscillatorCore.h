@@ -0,0 +1,219 @@
+/* OscillatorCore.h
+ *
+ *  Compile-time building blocks of the wavetable oscillator. The block render loop is a
+ *  template over a wave source and an interpolation policy, so each instantiation has a
+ *  branch-free inner loop; Oscillator picks an instantiation at run time through a
+ *  function pointer.
+ *
+ *  A wave source provides table(level) and shift(level), the single period table for a
+ *  mip level and the right shift from the 32-bit phase to its index. An interpolator
+ *  provides read(table, accumulator, shift), the table value at that phase. The morph loop
+ *  crossfades between two wave sources picked at the start of each block.
+ *
+ *  Square and saw are band limited: mip level k holds the harmonics up to
+ *  MIP_TOP_HARMONICS >> k, in a table of TAB_LEN >> k entries (no shorter than
+ *  MIP_MIN_LEN). Oscillator::setF0Norm() picks the level whose harmonics all stay below
+ *  Nyquist and the crossfade into the next level up, which the render loop applies. Sine
+ *  and the uploaded user table have a single table each.
+ */
+
+#ifndef OSCILLATORCORE_H
+#define OSCILLATORCORE_H
+
+#include "Oscillator.h"
+
+#define PHASE_FRAC_SCALE (2.3283064365e-10f)    // 2^-32
+
+// Entries in mip level k
+static constexpr int mipLength(int k) {
+  return (TAB_LEN >> k) > MIP_MIN_LEN ? (TAB_LEN >> k) : MIP_MIN_LEN;
+}
+
+// Entries in mip levels k and up
+static constexpr int mipStorage(int k) {
+  return k >= MIP_LEVELS ? 0 : mipLength(k) + mipStorage(k + 1);
+}
+
+// Wave tables are shared by all oscillators
+typedef struct WaveTables {
+  static float sine[TAB_LEN];
+  static float square[mipStorage(0)];     // Mip levels, one after the other
+  static float saw[mipStorage(0)];
+  static const float *volatile user;      // TAB_LEN samples; sine until one is uploaded
+  static int mip_offset[MIP_LEVELS];      // Start of each level
+  static int mip_shift[MIP_LEVELS];       // 32 - log2(level length)
+} WaveTables;
+
+/* Wave sources */
+
+struct SineWave {
+  static const bool mipmapped = false;
+  static inline const float *table(int level)  { return WaveTables::sine; }
+  static inline int shift(int level)  { return IDX_FRAC_RES; }
+};
+
+struct SquareWave {
+  static const bool mipmapped = true;
+  static inline const float *table(int level)  {
+    return WaveTables::square + WaveTables::mip_offset[level];
+  }
+  static inline int shift(int level)  { return WaveTables::mip_shift[level]; }
+};
+
+struct SawWave {
+  static const bool mipmapped = true;
+  static inline const float *table(int level)  {
+    return WaveTables::saw + WaveTables::mip_offset[level];
+  }
+  static inline int shift(int level)  { return WaveTables::mip_shift[level]; }
+};
+
+struct UserWave {
+  static const bool mipmapped = false;
+  static inline const float *table(int level)  { return WaveTables::user; }
+  static inline int shift(int level)  { return IDX_FRAC_RES; }
+};
+
+/* Interpolators */
+
+// Table entry at or below the phase. Cheapest; fine for the LFO
+struct InterpNone {
+  static inline float read(const float *table, uint32_t acc, int shift) {
+    return table[acc >> shift];
+  }
+};
+
+struct InterpLinear {
+  static inline float read(const float *table, uint32_t acc, int shift) {
+    uint32_t mask = 0xffffffff >> shift;
+    uint32_t i = acc >> shift;
+    float frac = (uint32_t)(acc << (32 - shift)) * PHASE_FRAC_SCALE;
+    float y0 = table[i];
+    float y1 = table[(i + 1) & mask];
+    return y0 + frac * (y1 - y0);
+  }
+};
+
+// 4-point, 3rd order Hermite (Catmull-Rom) through the two entries either side
+struct InterpCubic {
+  static inline float read(const float *table, uint32_t acc, int shift) {
+    uint32_t mask = 0xffffffff >> shift;
+    uint32_t i = acc >> shift;
+    float frac = (uint32_t)(acc << (32 - shift)) * PHASE_FRAC_SCALE;
+    float ym1 = table[(i - 1) & mask];
+    float y0 = table[i];
+    float y1 = table[(i + 1) & mask];
+    float y2 = table[(i + 2) & mask];
+    float c1 = 0.5f * (y1 - ym1);
+    float c2 = ym1 - 2.5f * y0 + 2.0f * y1 - 0.5f * y2;
+    float c3 = 0.5f * (y2 - ym1) + 1.5f * (y0 - y1);
+    return ((c3 * frac + c2) * frac + c1) * frac + y0;
+  }
+};
+
+/**
+ * Render n >= 1 samples, advancing the phase accumulator by phase per sample, from the
+ * selected mip level crossfaded into the next. Returns the last sample. Matches
+ * OscRenderFunction.
+ */
+template <class Wave, class Interp>
+struct OscillatorCore {
+  static float render(float *out, int n, uint32_t *accumulator, uint32_t phase,
+                      const OscTableSelect &select) {
+    int level = select.mip_level;
+    float mix = select.mip_mix;
+    const float *t0 = Wave::table(level);
+    int s0 = Wave::shift(level);
+    uint32_t acc = *accumulator;
+    if (!Wave::mipmapped || mix == 0.0f) {
+      for (int i = 0; i < n; i++) {
+        out[i] = Interp::read(t0, acc, s0);
+        acc += phase;         // Exploit 32-bit overflow to wrap back to zero
+      }
+    }
+    else {
+      const float *t1 = Wave::table(level + 1);
+      int s1 = Wave::shift(level + 1);
+      for (int i = 0; i < n; i++) {
+        float y0 = Interp::read(t0, acc, s0);
+        out[i] = y0 + mix * (Interp::read(t1, acc, s1) - y0);
+        acc += phase;
+      }
+    }
+    *accumulator = acc;
+    return out[n - 1];
+  }
+};
+
+/* Morphing */
+
+// One end of a morph: a wave source's table for the current level, and the next level
+typedef struct MorphTable {
+  const float *t0;
+  const float *t1;
+  int s0;
+  int s1;
+  float mix;
+} MorphTable;
+
+template <class Wave>
+static inline MorphTable morphTable(const OscTableSelect &select) {
+  MorphTable m;
+  int level = select.mip_level;
+  m.mix = Wave::mipmapped ? select.mip_mix : 0.0f;
+  m.t0 = Wave::table(level);
+  m.s0 = Wave::shift(level);
+  if (m.mix > 0.0f)
+    level++;
+  m.t1 = Wave::table(level);
+  m.s1 = Wave::shift(level);
+  return m;
+}
+
+static inline MorphTable morphTable(int shape, const OscTableSelect &select) {
+  switch (shape) {
+    case kWaveShapeSquare:
+      return morphTable<SquareWave>(select);
+    case kWaveShapeSaw:
+      return morphTable<SawWave>(select);
+    case kWaveShapeUser:
+      return morphTable<UserWave>(select);
+    case kWaveShapeSine:
+    default:
+      return morphTable<SineWave>(select);
+  }
+}
+
+template <class Interp>
+static inline float morphRead(const MorphTable &m, uint32_t acc) {
+  float y0 = Interp::read(m.t0, acc, m.s0);
+  return y0 + m.mix * (Interp::read(m.t1, acc, m.s1) - y0);
+}
+
+/**
+ * Render n >= 1 samples crossfaded between the two wave shapes either side of the morph
+ * position. The shapes are looked up once per block. Matches OscRenderFunction.
+ */
+template <class Interp>
+struct OscillatorMorph {
+  static float render(float *out, int n, uint32_t *accumulator, uint32_t phase,
+                      const OscTableSelect &select) {
+    float morph = select.morph;
+    int a = (int)morph;
+    if (a > kWaveShapeUser - 1)
+      a = kWaveShapeUser - 1;
+    float frac = morph - a;
+    MorphTable ma = morphTable(a, select);
+    MorphTable mb = morphTable(a + 1, select);
+    uint32_t acc = *accumulator;
+    for (int i = 0; i < n; i++) {
+      float ya = morphRead<Interp>(ma, acc);
+      out[i] = ya + frac * (morphRead<Interp>(mb, acc) - ya);
+      acc += phase;
+    }
+    *accumulator = acc;
+    return out[n - 1];
+  }
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include "TaskScheduler.h"
+#include <Arduino.h>
+#include <string.h>
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+TaskScheduler::TaskScheduler() : num_tasks(0) { }
+
+TaskScheduler::~TaskScheduler() { }
+
+int TaskScheduler::addPeriodic(const char *name, TaskFunction fn, uint32_t period_us,
+                               int priority, uint32_t deadline_us) {
+  return add(name, fn, NULL, period_us > 0 ? period_us : 1, priority, deadline_us);
+}
+
+int TaskScheduler::addEvent(const char *name, TaskFunction fn, TaskReadyFunction ready,
+                            int priority, uint32_t deadline_us) {
+  return add(name, fn, ready, 0, priority, deadline_us);
+}
+
+int TaskScheduler::add(const char *name, TaskFunction fn, TaskReadyFunction ready,
+                       uint32_t period_us, int priority, uint32_t deadline_us) {
+  if (num_tasks == MAX_TASKS)
+    return -1;
+  Task &task = tasks[num_tasks];
+  task.name = name;
+  task.fn = fn;
+  task.ready = ready;
+  task.period_us = period_us;
+  task.priority = priority;
+  task.deadline_us = deadline_us;
+  task.enabled = true;
+  task.release_us = micros() + period_us;
+  task.released = false;
+  memset(&task.stats, 0, sizeof(TaskStats));
+  return num_tasks++;
+}
+
+void TaskScheduler::setPeriod(int id, uint32_t period_us) {
+  if (id < 0 || id >= num_tasks || tasks[id].period_us == 0 || period_us == 0)
+    return;
+  tasks[id].period_us = period_us;
+  tasks[id].release_us = micros() + period_us;
+}
+
+void TaskScheduler::setEnabled(int id, bool enabled) {
+  if (id < 0 || id >= num_tasks)
+    return;
+  if (enabled && !tasks[id].enabled)
+    tasks[id].release_us = micros() + tasks[id].period_us;
+  tasks[id].enabled = enabled;
+  tasks[id].released = false;
+}
+
+/**
+ * Periodic tasks are due once their release time has passed. Event tasks are due when
+ * ready; the first time one is seen ready marks its release time for the deadline.
+ */
+bool TaskScheduler::isDue(Task &task, uint32_t now) {
+  if (!task.enabled)
+    return false;
+  if (task.period_us > 0)
+    return (int32_t)(now - task.release_us) >= 0;
+  if (!task.ready())
+    return false;
+  if (!task.released) {
+    task.released = true;
+    task.release_us = now;
+  }
+  return true;
+}
+
+int TaskScheduler::run() {
+
+  uint32_t now = micros();
+  int next = -1;
+  for (int i = 0; i < num_tasks; i++) {
+    if (!isDue(tasks[i], now))      // Evaluated for all tasks so event releases are timed
+      continue;
+    if (next == -1 || tasks[i].priority < tasks[next].priority)
+      next = i;
+  }
+  if (next == -1)
+    return -1;
+
+  Task &task = tasks[next];
+  uint32_t start = micros();
+  uint32_t latency = start - task.release_us;
+  if (latency > task.deadline_us)
+    task.stats.deadline_misses++;
+  if (latency > task.stats.max_latency_us)
+    task.stats.max_latency_us = latency;
+
+  task.fn();
+
+  uint32_t elapsed = micros() - start;
+  task.stats.runs++;
+  task.stats.total_us += elapsed;
+  if (elapsed > task.stats.max_us)
+    task.stats.max_us = elapsed;
+
+  // Schedule the next release, skipping periods that were missed entirely
+  if (task.period_us > 0) {
+    task.release_us += task.period_us;
+    if ((int32_t)(micros() - task.release_us) >= 0)
+      task.release_us = micros() + task.period_us;
+  }
+  else
+    task.released = false;
+
+  return next;
+}
+
+void TaskScheduler::resetStats() {
+  for (int i = 0; i < num_tasks; i++)
+    memset(&tasks[i].stats, 0, sizeof(TaskStats));
+}
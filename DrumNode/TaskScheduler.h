@@ -0,0 +1,76 @@
+/* TaskScheduler.h
+ *
+ *  Small static cooperative scheduler for the main loop. Tasks are either periodic (run
+ *  every period_us) or event driven (period zero, run when their ready() function returns
+ *  true). Each call to run() executes the single highest priority task that is due, so
+ *  urgent tasks never wait behind more than one lower priority task. A task that starts
+ *  later than its deadline after being released counts a deadline miss.
+ */
+
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <stdint.h>
+
+#define MAX_TASKS (8)
+
+typedef void (*TaskFunction)();
+typedef bool (*TaskReadyFunction)();
+
+typedef struct TaskStats {
+  uint32_t runs;
+  uint32_t deadline_misses;
+  uint32_t total_us;          // Total runtime
+  uint32_t max_us;            // Longest single run
+  uint32_t max_latency_us;    // Longest delay from release to start
+} TaskStats;
+
+class TaskScheduler {
+
+public:
+
+  TaskScheduler();
+  ~TaskScheduler();
+
+  // Add a task, returning its id (or -1 if full). Lower priority values run first.
+  int addPeriodic(const char *name, TaskFunction fn, uint32_t period_us, int priority,
+                  uint32_t deadline_us);
+  int addEvent(const char *name, TaskFunction fn, TaskReadyFunction ready, int priority,
+               uint32_t deadline_us);
+
+  void setPeriod(int id, uint32_t period_us);
+  void setEnabled(int id, bool enabled);
+
+  // Run the highest priority due task, if any. Returns the task id or -1.
+  int run();
+
+  // Stats
+  int count()  { return num_tasks; }
+  const char *getName(int id)  { return tasks[id].name; }
+  const TaskStats &getStats(int id)  { return tasks[id].stats; }
+  void resetStats();
+
+private:
+
+  typedef struct Task {
+    const char *name;
+    TaskFunction fn;
+    TaskReadyFunction ready;    // Event tasks only
+    uint32_t period_us;         // Zero for event tasks
+    uint32_t deadline_us;
+    int priority;
+    bool enabled;
+    uint32_t release_us;        // Next due time (periodic) or when first seen ready (event)
+    bool released;              // Event task has been seen ready
+    TaskStats stats;
+  } Task;
+
+  int add(const char *name, TaskFunction fn, TaskReadyFunction ready, uint32_t period_us,
+          int priority, uint32_t deadline_us);
+  bool isDue(Task &task, uint32_t now);
+
+  Task tasks[MAX_TASKS];
+  int num_tasks;
+};
+
+#endif
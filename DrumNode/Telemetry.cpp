@@ -0,0 +1,44 @@
+#include "Telemetry.h"
+#include <string.h>
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+Telemetry::Telemetry() :
+  osc_received(0), osc_errors(0), other_addresses(0), prop_sent(0), prop_received(0),
+  num_addresses(0), loops(0), loops_start(0), loops_start_ms(0) {
+  for (int i = 0; i < kEspNumFields; i++)
+    esp[i] = 0;
+}
+
+Telemetry::~Telemetry() { }
+
+/**
+ * Count a message by its full address (including any channel prefix). Addresses longer
+ * than the table's names are counted by their prefix.
+ */
+void Telemetry::countMessage(const char *address) {
+  osc_received++;
+  for (int i = 0; i < num_addresses; i++) {
+    if (strncmp(addresses[i].name, address, TELEMETRY_ADDRESS_LEN - 1) == 0) {
+      addresses[i].count++;
+      return;
+    }
+  }
+  if (num_addresses == TELEMETRY_MAX_ADDRESSES) {
+    other_addresses++;
+    return;
+  }
+  AddressCount &a = addresses[num_addresses++];
+  strncpy(a.name, address, TELEMETRY_ADDRESS_LEN - 1);
+  a.name[TELEMETRY_ADDRESS_LEN - 1] = '\0';
+  a.count = 1;
+}
+
+uint32_t Telemetry::loopsPerSecond(uint32_t now_ms) {
+  uint32_t elapsed_ms = now_ms - loops_start_ms;
+  uint32_t rate = 0;
+  if (elapsed_ms > 0)
+    rate = (uint64_t)(loops - loops_start) * 1000 / elapsed_ms;
+  loops_start = loops;
+  loops_start_ms = now_ms;
+  return rate;
+}
@@ -0,0 +1,66 @@
+/* Telemetry.h
+ *
+ *  Message plane counters for a node: OSC messages received (in total and per address),
+ *  packets dropped, propagation hops and the main loop rate, plus the ESP8266's relay
+ *  counters as it last reported them. Counts are totals since boot, so a lost report
+ *  loses nothing; the collector takes differences. Main loop only.
+ *
+ *  Addresses are counted in a small fixed table, filled in order of arrival. Messages to
+ *  addresses that don't fit are counted together.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+#define TELEMETRY_MAX_ADDRESSES (16)
+#define TELEMETRY_ADDRESS_LEN (28)
+
+typedef enum EspTelemetryField {
+  kEspUdpReceived = 0,  // OSC messages relayed to the Teensy
+  kEspUdpErrors,        // UDP packets that didn't parse as OSC
+  kEspSlipErrors,       // SLIP packets from the Teensy that didn't parse
+  kEspWifiReconnects,
+  kEspLoopsPerSecond,
+  kEspNumFields
+} EspTelemetryField;
+
+class Telemetry {
+
+public:
+
+  Telemetry();
+  ~Telemetry();
+
+  void countMessage(const char *address);
+  void countLoop()  { loops++; }
+  uint32_t loopsPerSecond(uint32_t now_ms);   // Since the previous call
+
+  int numAddresses()  { return num_addresses; }
+  const char *getAddress(int i)  { return addresses[i].name; }
+  uint32_t getAddressCount(int i)  { return addresses[i].count; }
+
+  uint32_t osc_received;        // Messages dispatched
+  uint32_t osc_errors;          // Packets dropped by incoming_msg.hasError()
+  uint32_t other_addresses;     // Messages to addresses not in the table
+  uint32_t prop_sent;           // Propagation hops
+  uint32_t prop_received;
+  uint32_t esp[kEspNumFields];  // Latest /esp/telemetry
+
+private:
+
+  typedef struct AddressCount {
+    char name[TELEMETRY_ADDRESS_LEN];
+    uint32_t count;
+  } AddressCount;
+
+  AddressCount addresses[TELEMETRY_MAX_ADDRESSES];
+  int num_addresses;
+
+  uint32_t loops;
+  uint32_t loops_start;
+  uint32_t loops_start_ms;
+};
+
+#endif
@@ -0,0 +1,179 @@
+#include "VoiceChannel.h"
+#include <math.h>
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+VoiceChannel::Voice::Voice(float sample_rate) :
+  vco(sample_rate, 60.0, kInterpCubic), egen(sample_rate, 100.0, 1.0, 100.0), note(-1),
+  started(0) { }
+
+VoiceChannel::VoiceChannel(float sample_rate) :
+  voices{sample_rate, sample_rate, sample_rate, sample_rate}, vco(voices[0].vco),
+  egen(voices[0].egen), vca_lfo_mod(0.0), follower_gate(true), env_sample(0.0), poly(1),
+  voice_gain(1.0f), gain_target(1.0f), note_count(0) {
+  gain_coeff = 1.0f - expf(-1000.0f / (VOICE_GAIN_SMOOTH_MS * sample_rate));
+}
+
+VoiceChannel::~VoiceChannel() { }
+
+/**
+ * Set the number of voices notes are allocated from. Voices dropped from the pool are
+ * released.
+ */
+void VoiceChannel::setPoly(int voices_used) {
+  if (voices_used < 1) voices_used = 1;
+  if (voices_used > VOICE_POOL_SIZE) voices_used = VOICE_POOL_SIZE;
+  for (int v = voices_used; v < VOICE_POOL_SIZE; v++) {
+    voices[v].egen.gate(false);
+    voices[v].note = -1;
+  }
+  poly = voices_used;
+}
+
+int VoiceChannel::noteOn(int note, float f0, float level) {
+  int v = poly == 1 ? 0 : allocate(note);
+  Voice &voice = voices[v];
+  voice.vco.setF0(f0);
+  voice.egen.setSustainLevel(level);
+  voice.egen.gate(true);
+  voice.note = note;
+  voice.started = ++note_count;
+  updateGain();               // Turn the other voices down as this one starts
+  return v;
+}
+
+/**
+ * Release the voices playing a note. With one voice, release voice 0 whatever its note.
+ */
+void VoiceChannel::noteOff(int note) {
+  if (poly == 1) {
+    egen.gate(false);
+    return;
+  }
+  for (int v = 0; v < poly; v++) {
+    if (voices[v].note == note)
+      voices[v].egen.gate(false);
+  }
+}
+
+int VoiceChannel::allocate(int note) {
+  for (int v = 0; v < poly; v++) {
+    if (voices[v].note == note)
+      return v;
+  }
+  for (int v = 0; v < poly; v++) {
+    if (voices[v].egen.getState() == kEnvelopeState_Idle)
+      return v;
+  }
+  int quietest = -1;
+  for (int v = 0; v < poly; v++) {
+    if (voices[v].egen.getState() == kEnvelopeState_Release &&
+        (quietest < 0 || voices[v].egen.getLevel() < voices[quietest].egen.getLevel()))
+      quietest = v;
+  }
+  if (quietest >= 0)
+    return quietest;
+  int oldest = 0;
+  for (int v = 1; v < poly; v++) {
+    if ((int32_t)(voices[v].started - voices[oldest].started) < 0)
+      oldest = v;
+  }
+  return oldest;
+}
+
+/**
+ * The state of the busiest voice: attack or sustain (a note held) over release, over
+ * idle.
+ */
+EnvelopeState VoiceChannel::getState() {
+  EnvelopeState state = kEnvelopeState_Idle;
+  for (int v = 0; v < VOICE_POOL_SIZE; v++) {
+    EnvelopeState s = voices[v].egen.getState();
+    if (s == kEnvelopeState_Attack || s == kEnvelopeState_Sustain)
+      return s;
+    if (s == kEnvelopeState_Release)
+      state = s;
+  }
+  return state;
+}
+
+// The loudest voice's envelope level
+float VoiceChannel::getLevel() {
+  float level = 0.0f;
+  for (int v = 0; v < VOICE_POOL_SIZE; v++) {
+    if (voices[v].egen.getLevel() > level)
+      level = voices[v].egen.getLevel();
+  }
+  return level;
+}
+
+void VoiceChannel::setPitchMod(float octaves) {
+  for (int v = 0; v < VOICE_POOL_SIZE; v++)
+    voices[v].vco.setPitchMod(octaves);
+}
+
+void VoiceChannel::updateGlide() {
+  for (int v = 0; v < VOICE_POOL_SIZE; v++)
+    voices[v].vco.updateGlide();
+}
+
+/**
+ * Aim the mix gain at 1 / the number of sounding voices, so a single note plays at full
+ * level at any poly setting and a full chord stays in range. The gain moves there a
+ * sample at a time (VOICE_GAIN_SMOOTH_MS), so voices starting and ending don't step it.
+ * noteOn() calls this too, so the target drops as a note starts rather than a block later.
+ */
+void VoiceChannel::updateGain() {
+  int sounding = 0;
+  for (int v = 0; v < VOICE_POOL_SIZE; v++) {
+    if (voices[v].egen.getState() != kEnvelopeState_Idle)
+      sounding++;
+  }
+  gain_target = sounding > 1 ? 1.0f / sounding : 1.0f;
+  if (fabsf(voice_gain - gain_target) < 1e-4f)
+    voice_gain = gain_target;
+}
+
+void VoiceChannel::setControlBlock(int samples) {
+  for (int v = 0; v < VOICE_POOL_SIZE; v++)
+    voices[v].vco.setControlBlock(samples);
+}
+
+float VoiceChannel::render(float lfo_sample) {
+  env_sample = egen.render();
+  float sample = vco.render() * env_sample;
+  for (int v = 1; v < VOICE_POOL_SIZE; v++) {
+    Voice &voice = voices[v];
+    if (voice.egen.getState() == kEnvelopeState_Idle)
+      continue;
+    float env = voice.egen.render();
+    sample += voice.vco.render() * env;
+  }
+  voice_gain += (gain_target - voice_gain) * gain_coeff;
+  sample *= voice_gain;
+  return vca_lfo_mod * lfo_sample * sample + (1.0f - vca_lfo_mod) * sample;
+}
+
+/**
+ * Each sounding voice renders its oscillator and envelope a block at a time into scratch
+ * blocks, then accumulates their product into out.
+ */
+void VoiceChannel::mixVoices(float *out, int n) {
+  for (int v = 1; v < VOICE_POOL_SIZE; v++) {
+    Voice &voice = voices[v];
+    if (voice.egen.getState() == kEnvelopeState_Idle)
+      continue;
+    for (int start = 0; start < n; start += VOICE_BLOCK_SAMPLES) {
+      int len = n - start < VOICE_BLOCK_SAMPLES ? n - start : VOICE_BLOCK_SAMPLES;
+      voice.vco.renderBlock(vco_block, len);
+      voice.egen.renderBlock(env_block, len, NULL);
+      for (int i = 0; i < len; i++)
+        out[start + i] += vco_block[i] * env_block[i];
+    }
+  }
+  if (voice_gain != 1.0f || gain_target != 1.0f) {
+    for (int i = 0; i < n; i++) {
+      voice_gain += (gain_target - voice_gain) * gain_coeff;
+      out[i] *= voice_gain;
+    }
+  }
+}
@@ -0,0 +1,81 @@
+/* VoiceChannel.h
+ *
+ *  One synthesis voice chain for a DAC output: a pool of oscillator and envelope voices
+ *  through an LFO VCA. Each channel has its own voices; the LFO is shared, so its sample
+ *  is passed in to render(). The oscillators interpolate cubically.
+ *
+ *  Voice 0 is the channel's primary voice (vco, egen): the follower gates it, channel 1's
+ *  propagates, and the graph and modulation matrix read it. With one voice (the default)
+ *  notes play on voice 0 alone. With more, noteOn() allocates from the pool, reusing the
+ *  voice already on the note, then an idle voice, then stealing the quietest voice in 
+ *  release, then the oldest. Idle voices are not rendered.
+ */
+
+#ifndef VOICECHANNEL_H
+#define VOICECHANNEL_H
+
+#include "Oscillator.h"
+#include "EnvelopeGenerator.h"
+
+#define VOICE_POOL_SIZE (4)       // Voices per channel (each is initialized in the constructor)
+#define VOICE_BLOCK_SAMPLES (64)  // Scratch block for mixVoices()
+#define VOICE_GAIN_SMOOTH_MS (5.0f)   // Time constant of the mix gain
+
+class VoiceChannel {
+
+public:
+
+  typedef struct Voice {
+    Voice(float sample_rate);
+    Oscillator vco;
+    EnvelopeGenerator egen;
+    int note;                 // MIDI note, or -1
+    uint32_t started;         // Note-on order, for stealing the oldest
+  } Voice;
+
+  VoiceChannel(float sample_rate);
+  ~VoiceChannel();
+
+  // Notes (main loop)
+  void setPoly(int voices_used);    // Voices used by notes [1, VOICE_POOL_SIZE]
+  int getPoly()  { return poly; }
+  int noteOn(int note, float f0, float level);      // Returns the voice
+  void noteOff(int note);
+
+  // Every voice, for the heartbeat
+  EnvelopeState getState();
+  float getLevel();
+
+  // Every voice (control block)
+  void setPitchMod(float octaves);
+  void updateGlide();
+  void updateGain();
+  void setControlBlock(int samples);
+
+  // Audio i/o. Renders the envelopes and the voices; returns [-1.0, 1.0]
+  float render(float lfo_sample);
+  // Block: add voices 1 and up to out, which holds voice 0 (vco * egen), and scale
+  void mixVoices(float *out, int n);
+
+  Voice voices[VOICE_POOL_SIZE];
+  Oscillator &vco;        // Voice 0
+  EnvelopeGenerator &egen;
+
+  float vca_lfo_mod;      // LFO modulation depth of the VCA [0.0, 1.0]
+  bool follower_gate;     // Whether the EGEN can be triggered by the input follower
+  float env_sample;       // Most recent EGEN sample (voice 0)
+
+private:
+
+  int allocate(int note);
+
+  int poly;
+  float voice_gain;       // Moves toward gain_target every sample
+  float gain_target;      // 1 / sounding voices, so a full chord stays in [-1.0, 1.0]
+  float gain_coeff;
+  uint32_t note_count;
+  float vco_block[VOICE_BLOCK_SAMPLES];
+  float env_block[VOICE_BLOCK_SAMPLES];
+};
+
+#endif
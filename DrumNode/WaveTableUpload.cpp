@@ -0,0 +1,62 @@
+#include "WaveTableUpload.h"
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+#define WAVE_UPLOAD_ALL (WAVE_UPLOAD_CHUNKS == 64 ? ~0ULL : (1ULL << WAVE_UPLOAD_CHUNKS) - 1)
+
+WaveTableUpload::WaveTableUpload() : staging(0), received(0), swap_pending(false) {
+  for (int i = 0; i < TAB_LEN; i++) {
+    tables[0][i] = 0.0f;
+    tables[1][i] = 0.0f;
+  }
+}
+
+WaveTableUpload::~WaveTableUpload() { }
+
+/**
+ * Memory for chunk's WAVE_UPLOAD_CHUNK_BYTES of little-endian float32 samples. Unavailable
+ * while a completed table waits for its swap (at most one audio block).
+ */
+uint8_t *WaveTableUpload::stage(int chunk) {
+  if (chunk < 0 || chunk >= WAVE_UPLOAD_CHUNKS || swap_pending)
+    return NULL;
+  return (uint8_t *)&tables[staging][chunk * WAVE_UPLOAD_CHUNK];
+}
+
+/**
+ * Mark a chunk written, replacing NaNs with zero and clipping to [-1, 1].
+ * The last outstanding chunk schedules the swap.
+ */
+bool WaveTableUpload::commitChunk(int chunk) {
+  if (chunk < 0 || chunk >= WAVE_UPLOAD_CHUNKS || swap_pending)
+    return false;
+  float *x = &tables[staging][chunk * WAVE_UPLOAD_CHUNK];
+  for (int i = 0; i < WAVE_UPLOAD_CHUNK; i++) {
+    if (x[i] != x[i])                 // NaN
+      x[i] = 0.0f;
+    else if (x[i] > 1.0f)
+      x[i] = 1.0f;
+    else if (x[i] < -1.0f)
+      x[i] = -1.0f;
+  }
+  received |= 1ULL << chunk;
+  if (received != WAVE_UPLOAD_ALL)
+    return false;
+  received = 0;
+  swap_pending = true;
+  return true;
+}
+
+int WaveTableUpload::chunksReceived() {
+  int n = 0;
+  for (uint64_t r = received; r; r &= r - 1)
+    n++;
+  return n;
+}
+
+bool WaveTableUpload::update() {
+  if (!swap_pending)
+    return false;
+  staging ^= 1;
+  swap_pending = false;
+  return true;
+}
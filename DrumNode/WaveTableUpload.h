@@ -0,0 +1,47 @@
+/* WaveTableUpload.h
+ *
+ *  Double-buffered user wave table, uploaded over OSC in chunks. Each chunk is written from
+ *  the main loop straight into the staging table (OSC blob to table memory, no copy or
+ *  allocation); once every chunk has arrived, update() swaps staging and active at the
+ *  next audio block boundary, so a render call never sees a partly written table.
+ *
+ *  Chunks may arrive in any order and may be resent. A full table is WAVE_UPLOAD_CHUNKS
+ *  packets.
+ */
+
+#ifndef WAVETABLEUPLOAD_H
+#define WAVETABLEUPLOAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Oscillator.h"
+
+#define WAVE_UPLOAD_CHUNK (32)          // Samples per chunk (128 bytes of float32 per packet)
+#define WAVE_UPLOAD_CHUNKS (TAB_LEN / WAVE_UPLOAD_CHUNK)    // At most 64 (chunk mask bits)
+#define WAVE_UPLOAD_CHUNK_BYTES (WAVE_UPLOAD_CHUNK * 4)
+
+class WaveTableUpload {
+
+public:
+
+  WaveTableUpload();
+  ~WaveTableUpload();
+
+  // Upload (main loop)
+  uint8_t *stage(int chunk);          // Staging memory for a chunk, or NULL if unavailable
+  bool commitChunk(int chunk);        // Returns true when this completes the table
+  int chunksReceived();
+
+  // Swap (audio interrupt, between render calls)
+  bool update();                      // Returns true if the active table changed
+  const float *getTable()  { return tables[staging ^ 1]; }
+
+private:
+
+  float tables[2][TAB_LEN];
+  volatile int staging;               // Table being uploaded; the other is active
+  uint64_t received;                  // Chunks written to the staging table
+  volatile bool swap_pending;
+};
+
+#endif
@@ -0,0 +1,221 @@
+/* EnvelopeGeneratorTest.cpp
+ *
+ *  Host tests for EnvelopeGenerator. The sketch builder only compiles the sketch folder
+ *  and src/, so this directory is left out of the firmware.
+ *
+ *  Build and run (from DrumNode/tests):
+ *    g++ -std=gnu++11 -Wall -Wno-reorder -I.. EnvelopeGeneratorTest.cpp
+ *        ../EnvelopeGenerator.cpp -o envelope_test && ./envelope_test
+ */
+
+#include "EnvelopeGenerator.h"
+#include "TestCheck.h"
+#include <stdlib.h>
+
+#define FS (8000.0f)
+
+// Render until idle; false if it takes longer than max_samples
+static bool renderToIdle(EnvelopeGenerator &egen, int max_samples) {
+  for (int i = 0; i < max_samples; i++) {
+    egen.render();
+    if (egen.getState() == kEnvelopeState_Idle)
+      return true;
+  }
+  return false;
+}
+
+static float renderMax(EnvelopeGenerator &egen, int n) {
+  float max = 0.0f;
+  for (int i = 0; i < n; i++) {
+    float v = egen.render();
+    if (v > max)
+      max = v;
+  }
+  return max;
+}
+
+/* === Breakpoint gate off === */
+
+// A note off once a one-shot shape has finished, or while idle, plays nothing
+static void testStrayNoteOff() {
+  float times[] = {10, 10, 10};
+  float targets[] = {1, 0.5f, 0};
+  EnvelopeRamp ramps[] = {kEnvelopeRamp_Linear, kEnvelopeRamp_Linear, kEnvelopeRamp_Linear};
+
+  EnvelopeGenerator egen(FS, 10, 1, 10);
+  egen.setBreakpoints(times, targets, ramps, 3, -1);
+  egen.gate(false);
+  check(egen.getState() == kEnvelopeState_Idle && renderMax(egen, 400) == 0.0f,
+        "note off while idle");
+
+  egen.gate(true);
+  check(renderToIdle(egen, 400), "one-shot shape finishes");
+  egen.gate(false);
+  check(egen.getState() == kEnvelopeState_Idle && renderMax(egen, 400) == 0.0f,
+        "note off after a one-shot shape");
+
+  // A note off during the tail leaves it to finish from where it is
+  egen.gate(true);
+  for (int i = 0; i < 100; i++)
+    egen.render();
+  float level = egen.getLevel();
+  egen.gate(false);
+  check(renderMax(egen, 400) <= level, "note off during a one-shot tail");
+}
+
+// The CV gate below its off threshold, every sample of a hold-then-fall release
+static void testReleaseUnderCvGate() {
+  float times[] = {5, 50, 50, 20};
+  float targets[] = {1, 1, 1, 0};
+  EnvelopeRamp ramps[] = {kEnvelopeRamp_Linear, kEnvelopeRamp_Linear, kEnvelopeRamp_Linear,
+                          kEnvelopeRamp_Linear};
+
+  EnvelopeGenerator egen(FS, 10, 1, 10);
+  egen.setBreakpoints(times, targets, ramps, 4, 1);
+  egen.setSustain(true);
+  egen.gate(true);
+  for (int i = 0; i < 800; i++)
+    egen.render();
+  check(egen.getState() == kEnvelopeState_Sustain, "breakpoint shape sustains");
+
+  egen.gate(false);
+  bool idle = false;
+  for (int i = 0; i < 2000 && !idle; i++) {
+    egen.gate_cv(0.0f);
+    egen.render();
+    idle = egen.getState() == kEnvelopeState_Idle;
+  }
+  check(idle, "hold-then-fall release finishes under the CV gate");
+}
+
+/* === Block vs. sample rendering === */
+
+#define BLOCK (64)
+
+/**
+ * Render the same gates and CV through renderBlock() on one generator and gate_cv() then
+ * render() per sample on another; returns the number of samples that differ. Notes are
+ * re-gated at random points, so some attacks start above the sustain level.
+ */
+static int compareBlocks(EnvelopeGenerator &a, EnvelopeGenerator &b, int blocks, int seed) {
+  srand(seed);
+  int diffs = 0;
+  int edges_a = 0, edges_b = 0;
+  float cv[BLOCK], out_a[BLOCK], out_b[BLOCK];
+  float env = 0.0f;
+  for (int blk = 0; blk < blocks; blk++) {
+    for (int i = 0; i < BLOCK; i++) {
+      if (rand() % 400 == 0)
+        env = 1.0f;
+      env *= 0.99f;
+      cv[i] = env;
+    }
+    int r = rand() % 16;
+    if (r == 0) {
+      float sus = 0.2f + 0.8f * (rand() % 100) / 100.0f;
+      a.setSustainLevel(sus);
+      b.setSustainLevel(sus);
+      a.gate(true);
+      b.gate(true);
+    }
+    else if (r == 1) {
+      a.gate(false);
+      b.gate(false);
+    }
+    for (int i = 0; i < BLOCK; i++) {
+      a.gate_cv(cv[i]);
+      out_a[i] = a.render();
+    }
+    b.renderBlock(out_b, BLOCK, cv);
+    for (int i = 0; i < BLOCK; i++) {
+      if (out_a[i] != out_b[i])
+        diffs++;
+    }
+    if (a.falling_edge) { edges_a++; a.falling_edge = false; }
+    if (b.falling_edge) { edges_b++; b.falling_edge = false; }
+  }
+  return diffs + (edges_a != edges_b);
+}
+
+static void testBlockAttackRelease() {
+  int diffs = 0;
+  for (int t = 0; t < 200; t++) {
+    srand(1000 + t);
+    float atk = 1 + rand() % 20, rel = 1 + rand() % 200;
+    EnvelopeRamp ramp = rand() % 2 ? kEnvelopeRamp_Exponential : kEnvelopeRamp_Linear;
+    bool sus = rand() % 2;
+    EnvelopeGenerator a(FS, atk, 1, rel), b(FS, atk, 1, rel);
+    a.setRamp(ramp);
+    b.setRamp(ramp);
+    a.setSustain(sus);
+    b.setSustain(sus);
+    diffs += compareBlocks(a, b, 200, t);
+  }
+  check(diffs == 0, "block attack/release matches per sample");
+}
+
+static void testBlockBreakpoints() {
+  int diffs = 0;
+  for (int t = 0; t < 200; t++) {
+    srand(2000 + t);
+    int n = 1 + rand() % EGEN_MAX_SEGMENTS;
+    float times[EGEN_MAX_SEGMENTS], targets[EGEN_MAX_SEGMENTS];
+    EnvelopeRamp ramps[EGEN_MAX_SEGMENTS];
+    for (int i = 0; i < n; i++) {
+      times[i] = rand() % 40;
+      targets[i] = rand() % 4 == 0 ? (i > 0 ? targets[i - 1] : 0.5f) : (rand() % 100) / 100.0f;
+      ramps[i] = rand() % 2 ? kEnvelopeRamp_Exponential : kEnvelopeRamp_Linear;
+    }
+    int sustain_point = rand() % 3 == 0 ? -1 : rand() % n;
+    bool sus = rand() % 2;
+    EnvelopeGenerator a(FS, 10, 1, 10), b(FS, 10, 1, 10);
+    a.setBreakpoints(times, targets, ramps, n, sustain_point);
+    b.setBreakpoints(times, targets, ramps, n, sustain_point);
+    a.setSustain(sus);
+    b.setSustain(sus);
+    diffs += compareBlocks(a, b, 200, t);
+  }
+  check(diffs == 0, "block breakpoints match per sample");
+}
+
+// Re-gating to a lower level starts an attack at or above its target, which ends at once
+static void testLowerRegate() {
+  int diffs = 0, stuck = 0;
+  for (int atk = 1; atk <= 7; atk++) {
+    for (int start = 0; start < 200; start++) {
+      EnvelopeGenerator a(FS, atk, 1, 100), b(FS, atk, 1, 100);
+      float out_a[BLOCK], out_b[BLOCK];
+      a.setSustain(true);
+      b.setSustain(true);
+      a.gate(true);
+      b.gate(true);
+      for (int i = 0; i < start; i++) {
+        a.render();
+        b.render();
+      }
+      a.setSustainLevel(0.375f);
+      b.setSustainLevel(0.375f);
+      a.gate(true);
+      b.gate(true);
+      for (int i = 0; i < BLOCK; i++)
+        out_a[i] = a.render();
+      b.renderBlock(out_b, BLOCK, NULL);
+      for (int i = 0; i < BLOCK; i++) {
+        if (out_a[i] != out_b[i])
+          diffs++;
+      }
+      if (b.getState() != kEnvelopeState_Sustain || b.getLevel() != 0.375f)
+        stuck++;
+    }
+  }
+  check(diffs == 0 && stuck == 0, "lower re-gate ends the attack");
+}
+
+int main() {
+  testStrayNoteOff();
+  testReleaseUnderCvGate();
+  testBlockAttackRelease();
+  testBlockBreakpoints();
+  testLowerRegate();
+  return testResult();
+}
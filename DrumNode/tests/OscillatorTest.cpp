@@ -0,0 +1,144 @@
+/* OscillatorTest.cpp
+ *
+ *  Host tests for Oscillator: aliasing of the band-limited square and saw tables, and
+ *  block rendering against per-sample rendering.
+ *
+ *  Build and run (from DrumNode/tests):
+ *    g++ -std=gnu++11 -O2 -Wall -Wno-reorder -I.. OscillatorTest.cpp ../Oscillator.cpp
+ *        -o oscillator_test && ./oscillator_test
+ */
+
+#include "Oscillator.h"
+#include "OscillatorCore.h"
+#include "TestCheck.h"
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+
+#define FS (8000.0f)
+#define DFT_LEN (8192)
+#define ALIAS_MAX_DB (-70.0)      // Mip tables measure -86 dB or lower; naive tables -6 to -20
+
+/**
+ * Power in DFT bins away from the harmonics of f0, relative to the total, in dB. The
+ * signal is windowed (4-term Blackman-Harris), so bins within a few of a harmonic count
+ * as harmonic.
+ */
+static double aliasPower(const std::vector<float> &x, float f0) {
+  int n = (int)x.size();
+  std::vector<double> w(n), c(n), s(n);
+  for (int i = 0; i < n; i++) {
+    double t = 2 * M_PI * i / n;
+    w[i] = x[i] * (0.35875 - 0.48829 * cos(t) + 0.14128 * cos(2 * t) - 0.01168 * cos(3 * t));
+    c[i] = cos(t);
+    s[i] = sin(t);
+  }
+  double total = 0, harmonic = 0;
+  for (int k = 1; k < n / 2; k++) {
+    double re = 0, im = 0;
+    for (int i = 0; i < n; i++) {
+      int j = (int)(((long)k * i) % n);
+      re += w[i] * c[j];
+      im -= w[i] * s[j];
+    }
+    double p = re * re + im * im;
+    total += p;
+    double h = k * FS / n / f0;
+    if (fabs(h - round(h)) * f0 < 5 * FS / n)
+      harmonic += p;
+  }
+  return 10 * log10((total - harmonic) / total);
+}
+
+static void testAliasing() {
+  // Not integer divisions of FS, so aliases land between the harmonics
+  const float freqs[] = {110, 437, 993, 1499};
+  const WaveShape shapes[] = {kWaveShapeSaw, kWaveShapeSquare};
+  const char *names[] = {"saw", "square"};
+  for (int s = 0; s < 2; s++) {
+    double worst = -1000;
+    for (int f = 0; f < 4; f++) {
+      Oscillator osc(FS, freqs[f], kInterpCubic);
+      osc.setWaveShape(shapes[s]);
+      std::vector<float> x(DFT_LEN), naive(DFT_LEN);
+      double phase = 0;
+      for (int i = 0; i < DFT_LEN; i++) {
+        x[i] = osc.render();
+        naive[i] = s == 0 ? 2 * phase - 1 : (phase < 0.5 ? 1 : -1);
+        phase += freqs[f] / FS;
+        phase -= floor(phase);
+      }
+      double db = aliasPower(x, freqs[f]);
+      double naive_db = aliasPower(naive, freqs[f]);
+      printf("      %s %4.0f Hz: %6.1f dB (naive %6.1f dB)\n", names[s], freqs[f], db, naive_db);
+      worst = fmax(worst, db);
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "%s aliasing below %.0f dB", names[s], ALIAS_MAX_DB);
+    check(worst < ALIAS_MAX_DB, name);
+  }
+}
+
+static void testTablePeak() {
+  Oscillator osc(FS, 100);          // Builds the tables
+  float peak = 0;
+  for (int i = 0; i < mipStorage(0); i++) {
+    peak = fmaxf(peak, fabsf(WaveTables::saw[i]));
+    peak = fmaxf(peak, fabsf(WaveTables::square[i]));
+  }
+  check(peak <= 1.0f, "mip tables peak at 1");
+}
+
+// A pitch sweep across the mip levels, rendered per block and per sample
+static void testBlockRender() {
+  const WaveShape shapes[] = {kWaveShapeSine, kWaveShapeSquare, kWaveShapeSaw};
+  const OscInterpolation interps[] = {kInterpNone, kInterpLinear, kInterpCubic};
+  int diffs = 0;
+  for (int s = 0; s < 3; s++) {
+    for (int in = 0; in < 3; in++) {
+      Oscillator a(FS, 50, interps[in]), b(FS, 50, interps[in]);
+      a.setWaveShape(shapes[s]);
+      b.setWaveShape(shapes[s]);
+      float out[64];
+      for (int blk = 0; blk < 500; blk++) {
+        float f0 = 50 * powf(2.0f, blk / 100.0f);
+        a.setF0(f0);
+        b.setF0(f0);
+        b.renderBlock(out, 64);
+        for (int i = 0; i < 64; i++) {
+          if (a.render() != out[i])
+            diffs++;
+        }
+      }
+    }
+  }
+  check(diffs == 0, "block render matches per sample");
+}
+
+// An exponential glide from 0 Hz has no pitch to start from, so it jumps to the target
+static void testGlideFromZero() {
+  Oscillator a(FS, 0), b(FS, 440);
+  a.setControlBlock(64);
+  b.setControlBlock(64);
+  a.setGlide(50, kGlideExponential);
+  a.setF0(440);
+  int diffs = 0;
+  for (int blk = 0; blk < 20; blk++) {
+    a.updateGlide();
+    b.updateGlide();
+    for (int i = 0; i < 64; i++) {
+      float x = a.render();
+      if (x != b.render() || x != x)
+        diffs++;
+    }
+  }
+  check(diffs == 0, "exponential glide from 0 Hz jumps to the target");
+}
+
+int main() {
+  testTablePeak();
+  testAliasing();
+  testBlockRender();
+  testGlideFromZero();
+  return testResult();
+}
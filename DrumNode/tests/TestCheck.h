@@ -0,0 +1,25 @@
+/* TestCheck.h
+ *
+ *  Assertions shared by the host tests: check() prints each result and counts failures,
+ *  and testResult() prints the total and returns main()'s exit status.
+ */
+
+#ifndef TESTCHECK_H
+#define TESTCHECK_H
+
+#include <stdio.h>
+
+static int failures = 0;
+
+static void check(bool ok, const char *name) {
+  printf("%s  %s\n", ok ? "pass" : "FAIL", name);
+  if (!ok)
+    failures++;
+}
+
+static int testResult() {
+  printf("%d failed\n", failures);
+  return failures > 0;
+}
+
+#endif
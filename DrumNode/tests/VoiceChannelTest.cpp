@@ -0,0 +1,142 @@
+/* VoiceChannelTest.cpp
+ *
+ *  Host tests for VoiceChannel: the voice pool's allocation and stealing order, the
+ *  block path (voice 0 rendered by its oscillator and envelope, then mixVoices()) against
+ *  per-sample render(), and the mix gain.
+ *
+ *  Build and run (from DrumNode/tests):
+ *    g++ -std=gnu++11 -Wall -Wno-reorder -I.. VoiceChannelTest.cpp ../VoiceChannel.cpp
+ *        ../Oscillator.cpp ../EnvelopeGenerator.cpp -o voice_test && ./voice_test
+ */
+
+#include "VoiceChannel.h"
+#include "TestCheck.h"
+#include <math.h>
+
+#define FS (8000.0f)
+#define BLOCK (64)
+
+static float mtof(int note) {
+  return 440.0f * powf(2.0f, (note - 69) / 12.0f);
+}
+
+// Sustaining voices with a 10 ms attack and 300 ms release
+static void setUp(VoiceChannel &ch, int poly) {
+  ch.setPoly(poly);
+  for (int v = 0; v < VOICE_POOL_SIZE; v++) {
+    ch.voices[v].egen.setAttackTime(10);
+    ch.voices[v].egen.setReleaseTime(300);
+    ch.voices[v].egen.setSustain(true);
+  }
+}
+
+// Render per sample, updating the mix gain every BLOCK samples; returns the peak
+static float renderMs(VoiceChannel &ch, float ms) {
+  float peak = 0.0f;
+  for (int i = 0; i < ms * FS * 0.001f; i++) {
+    if (i % BLOCK == 0)
+      ch.updateGain();
+    peak = fmaxf(peak, fabsf(ch.render(0.0f)));
+  }
+  return peak;
+}
+
+static void testAllocation() {
+  VoiceChannel ch(FS);
+  setUp(ch, 3);
+
+  int v60 = ch.noteOn(60, mtof(60), 0.8f);
+  renderMs(ch, 20);
+  int v64 = ch.noteOn(64, mtof(64), 0.8f);
+  renderMs(ch, 20);
+  int v67 = ch.noteOn(67, mtof(67), 0.8f);
+  renderMs(ch, 20);
+  check(v60 == 0 && v64 == 1 && v67 == 2, "idle voices first");
+
+  check(ch.noteOn(64, mtof(64), 0.8f) == v64, "same note reuses its voice");
+  renderMs(ch, 20);
+
+  ch.noteOff(60);
+  renderMs(ch, 100);
+  ch.noteOff(67);
+  renderMs(ch, 20);
+  check(ch.noteOn(72, mtof(72), 0.8f) == v60, "steals the quietest releasing voice");
+  renderMs(ch, 20);
+  check(ch.noteOn(74, mtof(74), 0.8f) == v67, "then the other releasing voice");
+  renderMs(ch, 20);
+
+  // All three held: 64 (re-struck) is now the oldest
+  check(ch.noteOn(76, mtof(76), 0.8f) == v64, "then the oldest voice");
+
+  VoiceChannel mono(FS);
+  setUp(mono, 1);
+  mono.noteOn(60, mtof(60), 0.8f);
+  check(mono.noteOn(64, mtof(64), 0.8f) == 0, "one voice plays every note on voice 0");
+}
+
+// Chords with stealing, rendered per sample and per block
+static void testBlockRender() {
+  VoiceChannel a(FS), b(FS);
+  setUp(a, 3);
+  setUp(b, 3);
+  const int notes[] = {60, 64, 67, 72, 60, 76};
+  int k = 0;
+  float max_err = 0.0f;
+  for (int blk = 0; blk < 200; blk++) {
+    if (blk % 20 == 0 && k < 6) {
+      a.noteOn(notes[k], mtof(notes[k]), 0.8f);
+      b.noteOn(notes[k], mtof(notes[k]), 0.8f);
+      k++;
+    }
+    if (blk == 130) {
+      a.noteOff(64);
+      b.noteOff(64);
+    }
+    a.updateGain();
+    b.updateGain();
+    float out[BLOCK], env[BLOCK];
+    b.vco.renderBlock(out, BLOCK);
+    b.egen.renderBlock(env, BLOCK, NULL);
+    for (int i = 0; i < BLOCK; i++)
+      out[i] *= env[i];
+    b.mixVoices(out, BLOCK);
+    for (int i = 0; i < BLOCK; i++)
+      max_err = fmaxf(max_err, fabsf(a.render(0.0f) - out[i]));
+  }
+  check(max_err == 0.0f, "block voices match per sample");
+}
+
+// A single note plays at the same level at any poly setting, and a settled chord no louder
+static void testGain() {
+  VoiceChannel mono(FS), poly(FS);
+  setUp(mono, 1);
+  setUp(poly, VOICE_POOL_SIZE);
+  mono.noteOn(69, 440, 1.0f);
+  poly.noteOn(69, 440, 1.0f);
+  renderMs(mono, 100);
+  renderMs(poly, 100);
+  float a = renderMs(mono, 50), b = renderMs(poly, 50);
+  check(a > 0.9f && a == b, "one note plays at the same level at any poly");
+
+  const int chord[] = {60, 64, 67, 70};
+  for (int k = 0; k < VOICE_POOL_SIZE; k++) {
+    poly.noteOn(chord[k], mtof(chord[k]), 1.0f);
+    renderMs(poly, 2);
+  }
+  renderMs(poly, 50);         // Let the gain settle
+  check(renderMs(poly, 200) <= a, "a full chord peaks no higher than one note");
+
+  // The heartbeat reports the busiest voice and the loudest level
+  poly.noteOff(60);
+  poly.noteOff(64);
+  renderMs(poly, 10);
+  check(poly.getState() == kEnvelopeState_Sustain && poly.getLevel() == 1.0f,
+        "held voices are reported over releasing ones");
+}
+
+int main() {
+  testAllocation();
+  testBlockRender();
+  testGain();
+  return testResult();
+}
@@ -3,6 +3,7 @@
 #include <ESP8266WiFi.h>
 #include <WiFiUDP.h>
 #include <OSCMessage.h>
+#include <OSCBundle.h>
 #include <SLIPEncodedSerial.h>
 #include <vector>
 
@@ -44,6 +45,14 @@ OSCMessage outgoing_msg;
 // SLIP Serial (ESP8266 <-> Teensy 3.2)
 SLIPEncodedSerial SLIPSerial(Serial);   
 
+// Telemetry counters, reported to the Teensy as /esp/telemetry when it sends /telemetry
+unsigned long udp_received = 0;       // OSC messages and bundles relayed to the Teensy
+unsigned long udp_errors = 0;         // UDP packets that failed to parse as OSC
+unsigned long slip_errors = 0;        // SLIP packets from the Teensy that failed to parse
+unsigned long wifi_reconnects = 0;    // Successful reconnects after the connection dropped
+unsigned long loops = 0;              // Since the last report
+unsigned long telemetryTime_ms = 0;
+
 void setup() {
 
   // WIFI Indicator LED
@@ -71,9 +80,12 @@ void loop() {
   handle_udp_local();     // OSC messages to local IP
   handle_udp_multi();     // OSC messages to multicast IP
   handle_osc_slip();      // OSC messages from Teensy to listeners
+  loops++;                // Loop rate for telemetry
 
-  if (WiFi.status() != WL_CONNECTED) 
-    connect_wifi();
+  if (WiFi.status() != WL_CONNECTED) {
+    if (connect_wifi())
+      wifi_reconnects++;
+  }
   else if (millis()-udpMultiMsgTime_ms > udpMultiLEDTime_ms)
     digitalWrite(PIN_LED, HIGH);
 }
@@ -145,6 +157,11 @@ void handle_udp_local() {
   
   int n_bytes = udpLocal.parsePacket();   // Number of available UDP bytes
   if (n_bytes) {
+
+    if (udpLocal.peek() == '#') {
+      handle_udp_bundle(udpLocal, n_bytes);
+      return;
+    }
     
     // Create OSC message from UDP bytes
     OSCMessage msg; 
@@ -163,11 +180,14 @@ void handle_udp_local() {
       }      
       
       slip_send(msg);   // ESP --> Teensy via SLIPSerial
+      udp_received++;
       digitalWrite(PIN_LED, LOW);
       udpMultiMsgTime_ms = millis();
     }
-    else 
+    else {
       error = msg.getError();
+      udp_errors++;
+    }
   }  
 }
 
@@ -175,6 +195,11 @@ void handle_udp_multi() {
   
   int n_bytes = udpMulti.parsePacket();   // Number of available UDP bytes
   if (n_bytes) {
+
+    if (udpMulti.peek() == '#') {
+      handle_udp_bundle(udpMulti, n_bytes);
+      return;
+    }
     
     // Create OSC message from UDP bytes
     OSCMessage msg; 
@@ -194,14 +219,50 @@ void handle_udp_multi() {
       
       if (msg.dispatch("/get_ip", handle_getip)) {}   // Handle local IP requests
       else slip_send(msg);                            // ESP --> Teensy via SLIPSerial
+      udp_received++;
       digitalWrite(PIN_LED, LOW);
       udpMultiMsgTime_ms = millis();
     }
-    else 
+    else {
       error = msg.getError();
+      udp_errors++;
+    }
   }  
 }
 
+/**
+ * Unpack an OSC bundle (coalesced parameter updates from the controller) and relay its
+ * messages to the Teensy one at a time.
+ */
+void handle_udp_bundle(WiFiUDP &udp, int n_bytes) {
+
+  OSCBundle bundle;
+  while (n_bytes--)
+    bundle.fill(udp.read());
+
+  if (!bundle.hasError()) {
+
+    // If the remote IP has changed, notify the Teensy of the most recent
+    if (udpRemoteIP != udp.remoteIP()) {
+      udpRemoteIP = udp.remoteIP();
+      OSCMessage ripMsg("/remote_ip");
+      for (int i = 0; i < 4; i++)  
+        ripMsg.add((uint32_t)udp.remoteIP()[i]);
+      slip_send(ripMsg);
+    }
+
+    for (int i = 0; i < bundle.size(); i++)
+      slip_send(*bundle.getOSCMessage(i));    // ESP --> Teensy via SLIPSerial
+    udp_received++;
+    digitalWrite(PIN_LED, LOW);
+    udpMultiMsgTime_ms = millis();
+  }
+  else {
+    error = bundle.getError();
+    udp_errors++;
+  }
+}
+
 /**
  * Handle OSC multicast requests for local IP. Create OSC message contatining local IP and 
  * send back to the IP/port that send the request.
@@ -215,6 +276,32 @@ void handle_getip(OSCMessage &msg) {
     udpMulti.endPacket(); 
 }
 
+/* ----------------- */
+/* === Telemetry === */
+/* ----------------- */
+
+/**
+ * Send the relay's counters to the Teensy in reply to each /telemetry packet it sends:
+ *   /esp/telemetry "iiiii" <udp_received><udp_errors><slip_errors><wifi_reconnects><loops_per_s>
+ * The Teensy forwards them in its next /telemetry packet, so nothing is sent until it has
+ * been asked for telemetry. Counts are totals since boot; the loop rate is since the last
+ * reply.
+ */
+void send_telemetry() {
+  unsigned long elapsed_ms = millis() - telemetryTime_ms;
+  if (elapsed_ms == 0)
+    return;
+  OSCMessage msg("/esp/telemetry");
+  msg.add((int32_t)udp_received);
+  msg.add((int32_t)udp_errors);
+  msg.add((int32_t)slip_errors);
+  msg.add((int32_t)wifi_reconnects);
+  msg.add((int32_t)(loops * 1000 / elapsed_ms));
+  slip_send(msg);
+  loops = 0;
+  telemetryTime_ms += elapsed_ms;
+}
+
 /* ------------------ */
 /* === SLIPSerial === */
 /* ------------------ */
@@ -262,8 +349,14 @@ void handle_osc_slip() {
 
   if (!msg.hasError()) {
     if (msg.dispatch("/set_dest", handle_set_dest)) {}   // 
-    else send_osc_local(msg);
+    else {
+      send_osc_local(msg);
+      if (msg.fullMatch("/telemetry"))
+        send_telemetry();
+    }
   }
+  else 
+    slip_errors++;
 }
 
 void handle_set_dest(OSCMessage &msg) {